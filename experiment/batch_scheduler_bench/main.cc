@@ -0,0 +1,198 @@
+// Exercises BatchScheduler without TensorFlow: TensorflowSynthesizer is
+// replaced with a stand-in which takes time proportional to the padded batch
+// size and encodes each input sequence into its output, so the caller can
+// check it got its own result back.
+//
+// Usage: ./batch_scheduler_bench [num_requests] [num_clients]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "batch_scheduler.h"
+#include "tf_synthesizer.h"
+
+namespace {
+
+// Output samples per input symbol.
+const size_t kSamplesPerSymbol = 4;
+
+std::mutex g_stats_mutex;
+std::vector<size_t> g_batch_sizes;
+size_t g_padded_symbols = 0;
+size_t g_symbols = 0;
+
+}  // namespace
+
+namespace tts {
+
+// Stand-in for the TensorFlow backed synthesizer. Only the batched
+// `synthesize` used by BatchScheduler is defined.
+class TensorflowSynthesizer::Impl {};
+
+TensorflowSynthesizer::TensorflowSynthesizer() : impl(new Impl()) {}
+
+TensorflowSynthesizer::~TensorflowSynthesizer() {}
+
+bool TensorflowSynthesizer::synthesize(
+    const std::vector<std::vector<int32_t>> &sequences,
+    std::vector<std::vector<float>> *outputs) {
+  size_t max_len = 0;
+  size_t total = 0;
+  for (const auto &seq : sequences) {
+    max_len = std::max(max_len, seq.size());
+    total += seq.size();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(g_stats_mutex);
+    g_batch_sizes.push_back(sequences.size());
+    g_padded_symbols += max_len * sequences.size();
+    g_symbols += total;
+  }
+
+  // Session run cost grows with the padded batch.
+  std::this_thread::sleep_for(
+      std::chrono::microseconds(200 + 5 * max_len * sequences.size()));
+
+  // Output = input symbols repeated, zero padded to the longest utterance.
+  outputs->assign(sequences.size(),
+                  std::vector<float>(max_len * kSamplesPerSymbol, 0.0f));
+  for (size_t i = 0; i < sequences.size(); i++) {
+    for (size_t t = 0; t < sequences[i].size() * kSamplesPerSymbol; t++) {
+      (*outputs)[i][t] = float(sequences[i][t / kSamplesPerSymbol]);
+    }
+  }
+
+  return true;
+}
+
+}  // namespace tts
+
+namespace {
+
+bool CheckResult(const std::vector<int32_t> &sequence,
+                 const tts::SynthesisResult &result) {
+  if (!result.ok) {
+    return false;
+  }
+  if (result.wav.size() < sequence.size() * kSamplesPerSymbol) {
+    return false;
+  }
+  for (size_t t = 0; t < result.wav.size(); t++) {
+    const size_t s = t / kSamplesPerSymbol;
+    const float expected = (s < sequence.size()) ? float(sequence[s]) : 0.0f;
+    if (result.wav[t] != expected) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const int num_requests = (argc > 1) ? std::max(1, atoi(argv[1])) : 2000;
+  const int num_clients = (argc > 2) ? std::max(1, atoi(argv[2])) : 16;
+
+  tts::TensorflowSynthesizer synthesizer;
+
+  tts::BatchSchedulerConfig config;
+  config.max_batch_size = 8;
+  config.max_wait_ms = 5;
+  config.num_workers = 2;
+
+  std::atomic<int> next(0);
+  std::atomic<int> num_failed(0);
+  std::atomic<long long> total_latency_us(0);
+  std::atomic<long long> max_latency_us(0);
+
+  const auto start = std::chrono::steady_clock::now();
+  {
+    tts::BatchScheduler scheduler(&synthesizer, config);
+
+    std::vector<std::thread> clients;
+    for (int c = 0; c < num_clients; c++) {
+      clients.emplace_back([&, c]() {
+        std::mt19937 rng(uint32_t(c + 1));
+        // Mostly short sentences and some long ones(incl. the overflow
+        // bucket).
+        std::uniform_int_distribution<int> short_len(1, 80);
+        std::uniform_int_distribution<int> long_len(81, 400);
+        std::uniform_int_distribution<int> pick(0, 9);
+
+        for (int id = next++; id < num_requests; id = next++) {
+          const int len = (pick(rng) < 8) ? short_len(rng) : long_len(rng);
+          // Unique symbols per request: (id, position).
+          std::vector<int32_t> sequence(static_cast<size_t>(len));
+          for (int t = 0; t < len; t++) {
+            sequence[size_t(t)] = id * 1000 + t % 1000 + 1;
+          }
+
+          const auto t0 = std::chrono::steady_clock::now();
+          tts::SynthesisResult result = scheduler.submit(sequence).get();
+          const long long us =
+              std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - t0)
+                  .count();
+          total_latency_us += us;
+          long long prev = max_latency_us.load();
+          while ((us > prev) && !max_latency_us.compare_exchange_weak(prev, us)) {
+          }
+
+          if (!CheckResult(sequence, result)) {
+            num_failed++;
+          }
+        }
+      });
+    }
+
+    for (auto &client : clients) {
+      client.join();
+    }
+
+    // Requests after shutdown must fail immediately.
+    scheduler.shutdown();
+    if (scheduler.submit(std::vector<int32_t>(10, 1)).get().ok) {
+      printf("submit() after shutdown succeeded\n");
+      num_failed++;
+    }
+  }
+  const double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  size_t max_batch = 0;
+  for (size_t n : g_batch_sizes) {
+    max_batch = std::max(max_batch, n);
+  }
+
+  printf("requests          : %d (%d clients)\n", num_requests, num_clients);
+  printf("batches           : %zu (mean size %.2f, max %zu)\n",
+         g_batch_sizes.size(),
+         double(num_requests) / double(std::max(size_t(1), g_batch_sizes.size())),
+         max_batch);
+  printf("padding overhead  : %.1f %%\n",
+         100.0 * double(g_padded_symbols - g_symbols) /
+             double(std::max(size_t(1), g_symbols)));
+  printf("latency           : mean %.2f ms, max %.2f ms\n",
+         double(total_latency_us.load()) / 1000.0 / double(num_requests),
+         double(max_latency_us.load()) / 1000.0);
+  printf("elapsed           : %.3f s\n", elapsed);
+  printf("mismatched results: %d\n", num_failed.load());
+
+  if (max_batch > config.max_batch_size) {
+    printf("batch larger than max_batch_size\n");
+    return EXIT_FAILURE;
+  }
+
+  return (num_failed.load() == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
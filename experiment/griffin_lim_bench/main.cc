@@ -0,0 +1,103 @@
+// Compares convergence of classic and fast(momentum) Griffin-Lim.
+//
+// Magnitude spectrogram of a synthetic harmonic signal is reconstructed with
+// both methods and spectral convergence is reported for each iteration.
+//
+// Usage: ./griffin_lim_bench [iterations] [momentum]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "fft.h"
+#include "griffin_lim.h"
+
+namespace {
+
+// 2 seconds of a vibrato tone with harmonics at 20kHz.
+std::vector<float> MakeSignal(size_t length, float sample_rate) {
+  const double kPi = 3.14159265358979323846;
+  std::vector<float> x(length);
+  double phase = 0.0;
+  for (size_t i = 0; i < length; i++) {
+    const double t = double(i) / double(sample_rate);
+    const double f0 = 180.0 + 30.0 * std::sin(2.0 * kPi * 3.0 * t);
+    phase += 2.0 * kPi * f0 / double(sample_rate);
+    double v = 0.0;
+    for (int h = 1; h <= 8; h++) {
+      v += std::sin(double(h) * phase) / double(h);
+    }
+    x[i] = float(0.3 * v);
+  }
+  return x;
+}
+
+std::vector<float> Magnitude(const std::vector<float>& x,
+                             const tts::GriffinLimConfig& config,
+                             size_t num_frames) {
+  const double kPi = 3.14159265358979323846;
+  std::shared_ptr<const tts::RealFFT> fft = tts::GetRealFFT(config.n_fft);
+  const size_t num_bins = fft->num_bins();
+
+  std::vector<float> mag(num_frames * num_bins);
+  std::vector<float> buf(config.n_fft), re(num_bins), im(num_bins),
+      work(config.n_fft);
+  for (size_t t = 0; t < num_frames; t++) {
+    for (size_t i = 0; i < config.n_fft; i++) {
+      const double w =
+          0.5 - 0.5 * std::cos(2.0 * kPi * double(i) / double(config.win_length));
+      buf[i] = (i < config.win_length)
+                   ? float(double(x[t * config.hop_length + i]) * w)
+                   : 0.0f;
+    }
+    fft->forward(buf.data(), re.data(), im.data(), work.data());
+    for (size_t k = 0; k < num_bins; k++) {
+      mag[t * num_bins + k] = std::sqrt(re[k] * re[k] + im[k] * im[k]);
+    }
+  }
+  return mag;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = (argc > 1) ? std::atoi(argv[1]) : 60;
+  const float momentum = (argc > 2) ? float(std::atof(argv[2])) : 0.99f;
+
+  tts::GriffinLimConfig config;
+  config.track_convergence = true;
+
+  const size_t num_frames = 160;
+  const std::vector<float> x = MakeSignal(
+      (num_frames - 1) * config.hop_length + config.win_length, 20000.0f);
+  const std::vector<float> mag = Magnitude(x, config, num_frames);
+
+  std::vector<double> sc[2];
+  double ms[2];
+  for (int m = 0; m < 2; m++) {
+    config.momentum = (m == 0) ? 0.0f : momentum;
+    tts::GriffinLim griffin_lim(config);
+
+    std::vector<float> y;
+    auto startT = std::chrono::steady_clock::now();
+    griffin_lim.run(mag.data(), num_frames, iterations, &y);
+    auto endT = std::chrono::steady_clock::now();
+
+    ms[m] = std::chrono::duration<double, std::milli>(endT - startT).count();
+    sc[m] = griffin_lim.convergence();
+  }
+
+  printf("# spectral convergence(lower is better), momentum = %f\n",
+         double(momentum));
+  printf("# iter     classic        fast\n");
+  for (size_t i = 0; i < sc[0].size(); i++) {
+    printf("%6d  %10.6f  %10.6f\n", int(i + 1), sc[0][i], sc[1][i]);
+  }
+  printf("# time [ms/iter] classic %f, fast %f\n",
+         ms[0] / std::max(1, iterations), ms[1] / std::max(1, iterations));
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,268 @@
+// Compares the post-processing chain of main.cc before fusion(copy out of
+// the tensor, inv_preemphasis, find_end_point, peak scan, quantization) with
+// the fused kernel(postprocess_audio + quantize_int16), and single-threaded
+// inverse preemphasis with the multithreaded one(inv_preemphasis_parallel),
+// also inside the fused kernel.
+// Also checks that streaming post-processing(PostProcessor fed with random
+// chunk sizes) gives the same audio as postprocess_audio.
+//
+// Usage: ./postprocess_bench [seconds] [repeat] [threads]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "audio_util.h"
+#include "post_processor.h"
+#include "thread_pool.h"
+
+namespace {
+
+const int kSampleRate = 20000;
+const float kPreemphasis = 0.97f;
+
+// Sentences of harmonic tones separated by short pauses, followed by 2
+// seconds of silence.
+std::vector<float> MakeSignal(size_t length) {
+  const double kPi = 3.14159265358979323846;
+  const size_t silence = 2 * size_t(kSampleRate);
+  std::vector<float> x(length + silence, 0.0f);
+  double phase = 0.0;
+  for (size_t i = 0; i < length; i++) {
+    const double t = double(i) / double(kSampleRate);
+    if (std::fmod(t, 3.0) > 2.6) {
+      continue;  // pause between sentences(shorter than min silence)
+    }
+    phase += 2.0 * kPi * (150.0 + 40.0 * std::sin(t)) / double(kSampleRate);
+    x[i] = float(0.1 * std::sin(phase) + 0.05 * std::sin(3.0 * phase));
+  }
+  return x;
+}
+
+// Post-processing before fusion(copied from the previous main.cc and
+// audio_util.cc).
+std::vector<float> OldInvPreemphasis(const float *x, size_t len, float scale) {
+  std::vector<float> y;
+  y.push_back(x[0]);
+  for (size_t i = 1; i < len; i++) {
+    y.emplace_back(x[i] + y[i - 1] * scale);
+  }
+  return y;
+}
+
+size_t OldFindEndPoint(const float *wav, size_t wav_len, size_t sample_rate) {
+  const size_t window_length = size_t(float(sample_rate) * 0.8f);
+  const size_t hop_length = window_length / 4;
+  const float threshold = std::pow(10.0f, -40.0f * 0.05f);
+  if (window_length > wav_len) {
+    return wav_len;
+  }
+  for (size_t x = hop_length; x < (wav_len - window_length); x += hop_length) {
+    const size_t end_pos = std::min(wav_len, x + window_length);
+    float m = *(std::max_element(wav + x, wav + end_pos));
+    if (m < threshold) {
+      return std::min(wav_len, x + hop_length);
+    }
+  }
+  return wav_len;
+}
+
+uint16_t OldFtous(const float x) {
+  int f = int(x);
+  return std::max(uint16_t(0),
+                  std::min(std::numeric_limits<uint16_t>::max(), uint16_t(f)));
+}
+
+size_t OldChain(const std::vector<float> &tensor, std::vector<uint16_t> *pcm,
+                float *peak) {
+  std::vector<float> wav(tensor.data(), tensor.data() + tensor.size());
+  std::vector<float> output =
+      OldInvPreemphasis(wav.data(), wav.size(), -kPreemphasis);
+  const size_t end_point =
+      OldFindEndPoint(output.data(), output.size(), kSampleRate);
+  output.resize(end_point);
+
+  float max_value = std::fabs(output[0]);
+  for (size_t i = 0; i < output.size(); i++) {
+    max_value = std::max(max_value, std::fabs(output[i]));
+  }
+  const float factor = 32767.0f / std::max(0.01f, max_value);
+  pcm->resize(output.size());
+  for (size_t i = 0; i < output.size(); i++) {
+    (*pcm)[i] = OldFtous(factor * output[i]);
+  }
+  (*peak) = max_value;
+  return end_point;
+}
+
+size_t FusedChain(const std::vector<float> &tensor, std::vector<float> *work,
+                  std::vector<int16_t> *pcm, float *peak,
+                  tts::ThreadPool *pool = nullptr) {
+  tts::PostProcessorConfig config;
+  config.sample_rate = kSampleRate;
+  config.preemphasis = kPreemphasis;
+
+  work->resize(tensor.size());
+  const size_t end_point = tts::postprocess_audio(
+      tensor.data(), tensor.size(), config, work->data(), peak, pool);
+  pcm->resize(end_point);
+  tts::quantize_int16(work->data(), end_point,
+                      32767.0f / std::max(0.01f, *peak), pcm->data());
+  return end_point;
+}
+
+// Feeds `tensor` to PostProcessor in chunks of random size(1 sample to 1
+// second) and compares the concatenated output with postprocess_audio.
+bool CheckStreaming(const std::vector<float> &tensor, uint32_t seed) {
+  tts::PostProcessorConfig config;
+  config.sample_rate = kSampleRate;
+  config.preemphasis = kPreemphasis;
+
+  std::vector<float> expected(tensor.size());
+  float peak;
+  const size_t end_point = tts::postprocess_audio(
+      tensor.data(), tensor.size(), config, expected.data(), &peak);
+  expected.resize(end_point);
+
+  std::vector<float> streamed;
+  tts::PostProcessor post_processor(config,
+                                    [&](const float *samples, size_t n) {
+                                      streamed.insert(streamed.end(), samples,
+                                                      samples + n);
+                                    });
+
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> chunk_length(1, size_t(kSampleRate));
+  size_t position = 0;
+  while (position < tensor.size()) {
+    const size_t n = std::min(chunk_length(rng), tensor.size() - position);
+    post_processor.push(tensor.data() + position, n);
+    position += n;
+  }
+  post_processor.finish();
+
+  if (streamed.size() != expected.size()) {
+    printf("  streaming length %zu != %zu\n", streamed.size(),
+           expected.size());
+    return false;
+  }
+  float max_diff = 0.0f;
+  for (size_t i = 0; i < expected.size(); i++) {
+    max_diff = std::max(max_diff, std::fabs(streamed[i] - expected[i]));
+  }
+  if (max_diff > 1e-4f * std::max(peak, 1e-30f)) {
+    printf("  streaming output mismatch(max diff %g)\n", double(max_diff));
+    return false;
+  }
+  return true;
+}
+
+template <typename F>
+double Measure(int repeat, F f) {
+  double best = 1e30;
+  for (int r = 0; r < repeat; r++) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    const double ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    best = std::min(best, ms);
+  }
+  return best;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const double seconds = (argc > 1) ? std::atof(argv[1]) : 300.0;
+  const int repeat = (argc > 2) ? std::atoi(argv[2]) : 10;
+  const size_t threads = (argc > 3) ? size_t(std::atoi(argv[3])) : 0;
+
+  const std::vector<float> tensor =
+      MakeSignal(size_t(seconds * double(kSampleRate)));
+
+  std::vector<uint16_t> old_pcm;
+  std::vector<int16_t> new_pcm;
+  std::vector<float> work;
+  float old_peak = 0.0f, new_peak = 0.0f;
+  size_t old_end = 0, new_end = 0;
+
+  const double old_ms = Measure(
+      repeat, [&]() { old_end = OldChain(tensor, &old_pcm, &old_peak); });
+  const double new_ms = Measure(repeat, [&]() {
+    new_end = FusedChain(tensor, &work, &new_pcm, &new_peak);
+  });
+
+  printf("%.0f sec audio(%zu samples)\n", seconds, tensor.size());
+  printf("  old chain : %8.2f ms(end point %zu, peak %f)\n", old_ms, old_end,
+         double(old_peak));
+  printf("  fused     : %8.2f ms(end point %zu, peak %f)\n", new_ms, new_end,
+         double(new_peak));
+  printf("  speedup   : %.2fx\n", old_ms / new_ms);
+
+  for (uint32_t seed = 1; seed <= 3; seed++) {
+    if (!CheckStreaming(tensor, seed)) {
+      return EXIT_FAILURE;
+    }
+  }
+  printf("  streaming : same output with random chunk sizes\n");
+
+  // Inverse preemphasis of the whole signal: chunks are filtered in
+  // parallel and corrected with the state of the previous chunk.
+  tts::ThreadPool pool(threads);
+  std::vector<float> serial(tensor.size()), parallel(tensor.size());
+  const double serial_ms = Measure(repeat, [&]() {
+    tts::inv_preemphasis(tensor.data(), tensor.size(), kPreemphasis,
+                         serial.data());
+  });
+  const double parallel_ms = Measure(repeat, [&]() {
+    tts::inv_preemphasis_parallel(tensor.data(), tensor.size(), kPreemphasis,
+                                  parallel.data(), pool);
+  });
+
+  float max_diff = 0.0f;
+  for (size_t i = 0; i < serial.size(); i++) {
+    max_diff = std::max(max_diff, std::fabs(serial[i] - parallel[i]));
+  }
+  const float max_abs = tts::peak_amplitude(serial.data(), serial.size());
+
+  printf("inverse preemphasis\n");
+  printf("  1 thread  : %8.2f ms\n", serial_ms);
+  printf("  %zu threads : %8.2f ms(max diff %g, relative %g)\n",
+         pool.num_threads(), parallel_ms, double(max_diff),
+         double(max_diff / std::max(max_abs, 1e-30f)));
+  if (max_diff > 1e-4f * max_abs) {
+    printf("  parallel output mismatch\n");
+    return EXIT_FAILURE;
+  }
+
+  // Fused kernel with the pool(what main.cc does for a single sentence).
+  std::vector<int16_t> pool_pcm;
+  float pool_peak = 0.0f;
+  size_t pool_end = 0;
+  const double pool_ms = Measure(repeat, [&]() {
+    pool_end = FusedChain(tensor, &work, &pool_pcm, &pool_peak, &pool);
+  });
+
+  size_t pcm_diff = 0;
+  for (size_t i = 0; i < std::min(new_pcm.size(), pool_pcm.size()); i++) {
+    pcm_diff = std::max(
+        pcm_diff, size_t(std::abs(int(new_pcm[i]) - int(pool_pcm[i]))));
+  }
+
+  printf("fused with %zu threads : %8.2f ms(end point %zu, peak %f, "
+         "max pcm diff %zu)\n",
+         pool.num_threads(), pool_ms, pool_end, double(pool_peak), pcm_diff);
+  if ((pool_end != new_end) || (pcm_diff > 1)) {
+    printf("  fused output mismatch with pool\n");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
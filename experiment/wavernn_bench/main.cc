@@ -0,0 +1,201 @@
+// Real-time factor of the WaveRNN vocoder with random block-sparse weights.
+// Writes a weight file in the format documented in wavernn.h, loads it with
+// tts::WaveRNN and synthesizes a random mel spectrogram.
+//
+// Usage: ./wavernn_bench [seconds] [rnn_dims] [fc_dims] [density] [weights.bin]
+//
+// The weight file(default: wavernn_random.bin) can also be given to
+// `tts --vocoder wavernn` to try the backend end-to-end(the output is noise).
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "wavernn.h"
+
+namespace {
+
+const uint32_t kSampleRate = 20000;
+const uint32_t kHopLength = 250;  // 12.5 ms
+const uint32_t kNumMels = 80;
+const uint32_t kCondDims = 128;
+const uint32_t kNumClasses = 256;
+const uint32_t kBlockRows = 8;
+const uint32_t kBlockCols = 4;
+
+class WeightWriter {
+ public:
+  WeightWriter(const std::string &filename, float block_density, uint32_t seed)
+      : os(filename, std::ios::binary), density(block_density), rng(seed) {}
+
+  bool good() const { return bool(os); }
+
+  void bytes(const void *p, size_t n) {
+    os.write(reinterpret_cast<const char *>(p), std::streamsize(n));
+  }
+
+  void u32(uint32_t v) { bytes(&v, sizeof(v)); }
+
+  // Uniform in [-range, range].
+  void floats(size_t n, float range) {
+    std::uniform_real_distribution<float> dist(-range, range);
+    std::vector<float> v(n);
+    for (auto &x : v) {
+      x = dist(rng);
+    }
+    bytes(v.data(), sizeof(float) * n);
+  }
+
+  // Each 8x4 block is kept with probability `density`(at least one block per
+  // block row). The row scale keeps pre-activations around unit variance.
+  void sparse(uint32_t rows, uint32_t cols) {
+    u32(rows);
+    u32(cols);
+
+    const float fan_in = std::max(float(kBlockCols), float(cols) * density);
+    const std::vector<float> scale(
+        rows, std::sqrt(3.0f / fan_in) / 127.0f);
+    bytes(scale.data(), sizeof(float) * rows);
+
+    std::uniform_real_distribution<float> keep(0.0f, 1.0f);
+    std::uniform_int_distribution<int> weight(-127, 127);
+    const uint32_t num_block_cols = cols / kBlockCols;
+    for (uint32_t r = 0; r < rows / kBlockRows; r++) {
+      std::vector<uint32_t> blocks;
+      for (uint32_t c = 0; c < num_block_cols; c++) {
+        if (keep(rng) < density) {
+          blocks.push_back(c);
+        }
+      }
+      if (blocks.empty()) {
+        blocks.push_back(r % num_block_cols);
+      }
+
+      u32(uint32_t(blocks.size()));
+      bytes(blocks.data(), sizeof(uint32_t) * blocks.size());
+
+      std::vector<int8_t> w(blocks.size() * kBlockRows * kBlockCols);
+      for (auto &x : w) {
+        x = int8_t(weight(rng));
+      }
+      bytes(w.data(), w.size());
+
+      num_blocks += blocks.size();
+      total_blocks += num_block_cols;
+    }
+  }
+
+  size_t num_blocks = 0;
+  size_t total_blocks = 0;
+
+ private:
+  std::ofstream os;
+  float density;
+  std::mt19937 rng;
+};
+
+bool WriteRandomWeights(const std::string &filename, uint32_t rnn_dims,
+                        uint32_t fc_dims, float density) {
+  WeightWriter w(filename, density, 1234);
+  if (!w.good()) {
+    fprintf(stderr, "Failed to open %s\n", filename.c_str());
+    return false;
+  }
+
+  const uint32_t gates = 3 * rnn_dims;
+
+  w.bytes("TTSWRNN1", 8);
+  w.u32(kSampleRate);
+  w.u32(kHopLength);
+  w.u32(kNumMels);
+  w.u32(kCondDims);
+  w.u32(rnn_dims);
+  w.u32(fc_dims);
+  w.u32(kNumClasses);
+  w.u32(0);  // flags: not pre-emphasized
+
+  w.floats(size_t(kCondDims) * kNumMels, std::sqrt(3.0f / float(kNumMels)));
+  w.floats(kCondDims, 0.1f);
+  w.floats(size_t(gates) * kCondDims, std::sqrt(3.0f / float(kCondDims)));
+  w.floats(gates, 1.0f);
+  w.floats(gates, 0.1f);
+  w.sparse(gates, rnn_dims);
+  w.floats(gates, 0.1f);
+  w.sparse(fc_dims, rnn_dims);
+  w.floats(fc_dims, 0.1f);
+  w.sparse(kNumClasses, fc_dims);
+  w.floats(kNumClasses, 0.1f);
+
+  printf("block density     : %.3f\n",
+         double(w.num_blocks) / double(std::max(size_t(1), w.total_blocks)));
+
+  return w.good();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const double seconds = (argc > 1) ? atof(argv[1]) : 5.0;
+  const uint32_t rnn_dims = (argc > 2) ? uint32_t(atoi(argv[2])) : 384;
+  const uint32_t fc_dims = (argc > 3) ? uint32_t(atoi(argv[3])) : 256;
+  const float density = (argc > 4) ? float(atof(argv[4])) : 0.125f;
+  const std::string filename = (argc > 5) ? argv[5] : "wavernn_random.bin";
+
+  if ((seconds <= 0.0) || (rnn_dims == 0) || (rnn_dims % kBlockRows) ||
+      (fc_dims == 0) || (fc_dims % kBlockRows) || (density <= 0.0f)) {
+    fprintf(stderr, "rnn_dims and fc_dims must be multiples of %u.\n",
+            kBlockRows);
+    return EXIT_FAILURE;
+  }
+
+  if (!WriteRandomWeights(filename, rnn_dims, fc_dims, density)) {
+    return EXIT_FAILURE;
+  }
+
+  tts::WaveRNN wavernn;
+  if (!wavernn.load(filename)) {
+    return EXIT_FAILURE;
+  }
+  wavernn.set_seed(1);
+
+  // Normalized mel spectrogram is in [0, 1].
+  const size_t num_frames =
+      size_t(seconds * double(kSampleRate) / double(kHopLength));
+  std::mt19937 rng(5678);
+  std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+  std::vector<float> mel(num_frames * kNumMels);
+  for (auto &x : mel) {
+    x = dist(rng);
+  }
+
+  std::vector<float> wav;
+  const auto start = std::chrono::steady_clock::now();
+  if (!wavernn.synthesize(mel.data(), num_frames, &wav)) {
+    return EXIT_FAILURE;
+  }
+  const double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  if (wav.size() != num_frames * kHopLength) {
+    fprintf(stderr, "Unexpected output length %zu (expected %zu)\n",
+            wav.size(), num_frames * size_t(kHopLength));
+    return EXIT_FAILURE;
+  }
+
+  const double audio_seconds = double(wav.size()) / double(kSampleRate);
+  printf("rnn/fc dims       : %u / %u\n", rnn_dims, fc_dims);
+  printf("audio             : %.2f s (%zu frames)\n", audio_seconds,
+         num_frames);
+  printf("synthesis         : %.3f s\n", elapsed);
+  printf("real-time factor  : %.3f\n", elapsed / audio_seconds);
+
+  return EXIT_SUCCESS;
+}
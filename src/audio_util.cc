@@ -2,6 +2,17 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "thread_pool.h"
 
 namespace tts {
 
@@ -9,10 +20,344 @@ namespace {
 
 float db_to_amp(const float x) { return std::pow(10.0f, x * 0.05f); }
 
+//
+// Polynomial exp2/log2 approximations used by the spectrogram kernels.
+//
+// exp2(y) = 2^n * p(f), n = round(y), f = y - n in [-0.5, 0.5].
+// p is the degree 6 Taylor polynomial of e^(f ln2). Truncation error is
+// below (0.5 ln2)^7 / 7! = 1.2e-7(relative), so the result is within a few
+// ulp of std::exp2. `y` is clamped to [-126, 126](no denormals/infinity).
+//
+// log2(x) = e + log2(m), x = m * 2^e, m in [sqrt(0.5), sqrt(2)).
+// log2(m) = 2 / ln2 * atanh(s), s = (m - 1) / (m + 1), |s| <= 0.172,
+// with the series of atanh up to s^9(truncation error < 3e-9). `x` must be
+// a positive normal number.
+//
+// Measured against double precision pow with power = 1.5: relative error
+// < 1.5e-6 for spectrogram_to_amplitude(spec = [0, 1], min_level_db = -100)
+// and < 4e-6 for amplitude_power(x = [1e-10, 1e5]). Most of it comes from
+// rounding of the float exponent, not from the polynomials.
+//
+constexpr float kExp2Min = -126.0f;
+constexpr float kExp2Max = 126.0f;
+
+constexpr float kExp2C1 = 0.6931471806f;   // ln2
+constexpr float kExp2C2 = 0.2402265070f;   // ln2^2 / 2!
+constexpr float kExp2C3 = 0.0555041087f;   // ln2^3 / 3!
+constexpr float kExp2C4 = 0.0096181291f;   // ln2^4 / 4!
+constexpr float kExp2C5 = 0.0013333558f;   // ln2^5 / 5!
+constexpr float kExp2C6 = 0.0001540353f;   // ln2^6 / 6!
+
+constexpr float kLog2C1 = 2.8853900818f;   // 2 / ln2
+constexpr float kLog2C3 = 0.9617966939f;   // 2 / (3 ln2)
+constexpr float kLog2C5 = 0.5770780164f;   // 2 / (5 ln2)
+constexpr float kLog2C7 = 0.4121985831f;   // 2 / (7 ln2)
+constexpr float kLog2C9 = 0.3205988980f;   // 2 / (9 ln2)
+
+constexpr float kSqrt2 = 1.4142135624f;
+
+float Exp2(float y) {
+  y = std::min(kExp2Max, std::max(kExp2Min, y));
+  const float n = std::floor(y + 0.5f);
+  const float f = y - n;
+  const float p =
+      1.0f +
+      f * (kExp2C1 +
+           f * (kExp2C2 +
+                f * (kExp2C3 + f * (kExp2C4 + f * (kExp2C5 + f * kExp2C6)))));
+  const uint32_t bits = uint32_t(int32_t(n) + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(float));
+  return p * scale;
+}
+
+float Log2(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(float));
+  float e = float(int32_t(bits >> 23) - 127);
+  bits = (bits & 0x007fffffu) | 0x3f800000u;
+  float m;
+  std::memcpy(&m, &bits, sizeof(float));
+  if (m > kSqrt2) {
+    m *= 0.5f;
+    e += 1.0f;
+  }
+  const float s = (m - 1.0f) / (m + 1.0f);
+  const float s2 = s * s;
+  return e +
+         s * (kLog2C1 +
+              s2 * (kLog2C3 + s2 * (kLog2C5 + s2 * (kLog2C7 + s2 * kLog2C9))));
+}
+
+#if defined(__AVX2__) && defined(__FMA__)
+__m256 Exp2(__m256 y) {
+  y = _mm256_min_ps(_mm256_set1_ps(kExp2Max),
+                    _mm256_max_ps(_mm256_set1_ps(kExp2Min), y));
+  const __m256i n = _mm256_cvtps_epi32(y);  // round to nearest
+  const __m256 f = _mm256_sub_ps(y, _mm256_cvtepi32_ps(n));
+  __m256 p = _mm256_set1_ps(kExp2C6);
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(kExp2C5));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(kExp2C4));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(kExp2C3));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(kExp2C2));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(kExp2C1));
+  p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.0f));
+  const __m256i bits =
+      _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(bits));
+}
+
+__m256 Log2(__m256 x) {
+  const __m256i bits = _mm256_castps_si256(x);
+  __m256 e = _mm256_cvtepi32_ps(_mm256_sub_epi32(
+      _mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+  __m256 m = _mm256_castsi256_ps(
+      _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                      _mm256_set1_epi32(0x3f800000)));
+  const __m256 large = _mm256_cmp_ps(m, _mm256_set1_ps(kSqrt2), _CMP_GT_OQ);
+  m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), large);
+  e = _mm256_add_ps(e, _mm256_and_ps(large, _mm256_set1_ps(1.0f)));
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 s =
+      _mm256_div_ps(_mm256_sub_ps(m, one), _mm256_add_ps(m, one));
+  const __m256 s2 = _mm256_mul_ps(s, s);
+  __m256 p = _mm256_set1_ps(kLog2C9);
+  p = _mm256_fmadd_ps(p, s2, _mm256_set1_ps(kLog2C7));
+  p = _mm256_fmadd_ps(p, s2, _mm256_set1_ps(kLog2C5));
+  p = _mm256_fmadd_ps(p, s2, _mm256_set1_ps(kLog2C3));
+  p = _mm256_fmadd_ps(p, s2, _mm256_set1_ps(kLog2C1));
+  return _mm256_fmadd_ps(p, s, e);
+}
+#endif
+
+#if defined(__SSE2__)
+__m128 Exp2(__m128 y) {
+  y = _mm_min_ps(_mm_set1_ps(kExp2Max), _mm_max_ps(_mm_set1_ps(kExp2Min), y));
+  const __m128i n = _mm_cvtps_epi32(y);  // round to nearest
+  const __m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(n));
+  __m128 p = _mm_set1_ps(kExp2C6);
+  p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2C5));
+  p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2C4));
+  p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2C3));
+  p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2C2));
+  p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(kExp2C1));
+  p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+  const __m128i bits = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+  return _mm_mul_ps(p, _mm_castsi128_ps(bits));
+}
+
+__m128 Log2(__m128 x) {
+  const __m128i bits = _mm_castps_si128(x);
+  __m128 e = _mm_cvtepi32_ps(
+      _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+  __m128 m = _mm_castsi128_ps(
+      _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                   _mm_set1_epi32(0x3f800000)));
+  const __m128 large = _mm_cmpgt_ps(m, _mm_set1_ps(kSqrt2));
+  m = _mm_or_ps(_mm_andnot_ps(large, m),
+                _mm_and_ps(large, _mm_mul_ps(m, _mm_set1_ps(0.5f))));
+  e = _mm_add_ps(e, _mm_and_ps(large, _mm_set1_ps(1.0f)));
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 s = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+  const __m128 s2 = _mm_mul_ps(s, s);
+  __m128 p = _mm_set1_ps(kLog2C9);
+  p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(kLog2C7));
+  p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(kLog2C5));
+  p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(kLog2C3));
+  p = _mm_add_ps(_mm_mul_ps(p, s2), _mm_set1_ps(kLog2C1));
+  return _mm_add_ps(_mm_mul_ps(p, s), e);
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+float32x4_t Exp2(float32x4_t y) {
+  y = vminq_f32(vdupq_n_f32(kExp2Max), vmaxq_f32(vdupq_n_f32(kExp2Min), y));
+  const int32x4_t n = vcvtnq_s32_f32(y);  // round to nearest
+  const float32x4_t f = vsubq_f32(y, vcvtq_f32_s32(n));
+  float32x4_t p = vdupq_n_f32(kExp2C6);
+  p = vfmaq_f32(vdupq_n_f32(kExp2C5), p, f);
+  p = vfmaq_f32(vdupq_n_f32(kExp2C4), p, f);
+  p = vfmaq_f32(vdupq_n_f32(kExp2C3), p, f);
+  p = vfmaq_f32(vdupq_n_f32(kExp2C2), p, f);
+  p = vfmaq_f32(vdupq_n_f32(kExp2C1), p, f);
+  p = vfmaq_f32(vdupq_n_f32(1.0f), p, f);
+  const int32x4_t bits = vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23);
+  return vmulq_f32(p, vreinterpretq_f32_s32(bits));
+}
+
+float32x4_t Log2(float32x4_t x) {
+  const uint32x4_t bits = vreinterpretq_u32_f32(x);
+  float32x4_t e = vcvtq_f32_s32(vsubq_s32(
+      vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+  float32x4_t m = vreinterpretq_f32_u32(
+      vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007fffff)),
+                vdupq_n_u32(0x3f800000)));
+  const uint32x4_t large = vcgtq_f32(m, vdupq_n_f32(kSqrt2));
+  m = vbslq_f32(large, vmulq_f32(m, vdupq_n_f32(0.5f)), m);
+  e = vaddq_f32(e, vbslq_f32(large, vdupq_n_f32(1.0f), vdupq_n_f32(0.0f)));
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t s = vdivq_f32(vsubq_f32(m, one), vaddq_f32(m, one));
+  const float32x4_t s2 = vmulq_f32(s, s);
+  float32x4_t p = vdupq_n_f32(kLog2C9);
+  p = vfmaq_f32(vdupq_n_f32(kLog2C7), p, s2);
+  p = vfmaq_f32(vdupq_n_f32(kLog2C5), p, s2);
+  p = vfmaq_f32(vdupq_n_f32(kLog2C3), p, s2);
+  p = vfmaq_f32(vdupq_n_f32(kLog2C1), p, s2);
+  return vfmaq_f32(e, p, s);
+}
+#endif
+
+//
+// Index of the last sample in x[0, n) which is not below `threshold`, or n
+// if there is none. Blocks are tested from the end, recording the last loud
+// index with a branch free select(vectorized), so each sample is read once
+// and loud audio returns after reading one block.
+//
+size_t LastLoudSample(const float *x, const size_t n, const float threshold,
+                      const bool absolute) {
+  const size_t kBlock = 64;
+  size_t block_end = n;
+  while (block_end > 0) {
+    const size_t block_begin = (block_end > kBlock) ? block_end - kBlock : 0;
+    // 1 + index of the last loud sample in the block, 0 = none.
+    size_t last = 0;
+    if (absolute) {
+      for (size_t i = block_begin; i < block_end; i++) {
+        last = (std::fabs(x[i]) >= threshold) ? (i + 1) : last;
+      }
+    } else {
+      for (size_t i = block_begin; i < block_end; i++) {
+        last = (x[i] >= threshold) ? (i + 1) : last;
+      }
+    }
+    if (last > 0) {
+      return last - 1;
+    }
+    block_end = block_begin;
+  }
+  return n;
+}
+
+//
+// First order IIR y[n] = x[n] + a * y[n - 1] as a block prefix scan.
+//
+// For 4 lanes, y = scan(x) + [a, a^2, a^3, a^4] * y[-1], where the local
+// scan(x) needs no previous output: two shift-multiply-add steps
+// (log2(4) = 2). Four vectors(16 samples) are combined with each other in
+// the same way, so the only loop carried dependency is one multiply-add and
+// a broadcast of the last lane per 16 samples, instead of a multiply-add
+// per sample.
+//
+// Summation order differs from the sequential filter, so results differ in
+// the last few ulp.
+//
+float InvPreemphasisKernel(const float *x, const size_t len, const float a,
+                           float *y, float state) {
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const float a2 = a * a;
+  const float a4 = a2 * a2;
+  const __m128 va = _mm_set1_ps(a);
+  const __m128 va2 = _mm_set1_ps(a2);
+  const __m128 p0 = _mm_setr_ps(a, a2, a2 * a, a4);  // a^1..a^4
+  const __m128 p1 = _mm_mul_ps(p0, _mm_set1_ps(a4));  // a^5..a^8
+  const __m128 p2 = _mm_mul_ps(p1, _mm_set1_ps(a4));  // a^9..a^12
+  const __m128 p3 = _mm_mul_ps(p2, _mm_set1_ps(a4));  // a^13..a^16
+
+  auto scan = [&](__m128 t) {
+    t = _mm_add_ps(
+        t, _mm_mul_ps(va, _mm_castsi128_ps(_mm_slli_si128(
+                              _mm_castps_si128(t), 4))));
+    t = _mm_add_ps(
+        t, _mm_mul_ps(va2, _mm_castsi128_ps(_mm_slli_si128(
+                               _mm_castps_si128(t), 8))));
+    return t;
+  };
+  auto last = [](__m128 t) { return _mm_shuffle_ps(t, t, 0xff); };
+
+  __m128 carry = _mm_set1_ps(state);
+  for (; i + 16 <= len; i += 16) {
+    const __m128 u0 = scan(_mm_loadu_ps(x + i));
+    const __m128 u1 =
+        _mm_add_ps(scan(_mm_loadu_ps(x + i + 4)), _mm_mul_ps(p0, last(u0)));
+    const __m128 u2 =
+        _mm_add_ps(scan(_mm_loadu_ps(x + i + 8)), _mm_mul_ps(p0, last(u1)));
+    const __m128 u3 =
+        _mm_add_ps(scan(_mm_loadu_ps(x + i + 12)), _mm_mul_ps(p0, last(u2)));
+    _mm_storeu_ps(y + i, _mm_add_ps(u0, _mm_mul_ps(p0, carry)));
+    _mm_storeu_ps(y + i + 4, _mm_add_ps(u1, _mm_mul_ps(p1, carry)));
+    _mm_storeu_ps(y + i + 8, _mm_add_ps(u2, _mm_mul_ps(p2, carry)));
+    const __m128 y3 = _mm_add_ps(u3, _mm_mul_ps(p3, carry));
+    _mm_storeu_ps(y + i + 12, y3);
+    carry = last(y3);
+  }
+  state = _mm_cvtss_f32(carry);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float a2 = a * a;
+  const float a4 = a2 * a2;
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  const float32x4_t p0 = {a, a2, a2 * a, a4};  // a^1..a^4
+  const float32x4_t p1 = vmulq_n_f32(p0, a4);  // a^5..a^8
+  const float32x4_t p2 = vmulq_n_f32(p1, a4);  // a^9..a^12
+  const float32x4_t p3 = vmulq_n_f32(p2, a4);  // a^13..a^16
+
+  auto scan = [&](float32x4_t t) {
+    t = vfmaq_n_f32(t, vextq_f32(zero, t, 3), a);
+    t = vfmaq_n_f32(t, vextq_f32(zero, t, 2), a2);
+    return t;
+  };
+
+  float32x4_t carry = vdupq_n_f32(state);
+  for (; i + 16 <= len; i += 16) {
+    const float32x4_t u0 = scan(vld1q_f32(x + i));
+    const float32x4_t u1 =
+        vfmaq_laneq_f32(scan(vld1q_f32(x + i + 4)), p0, u0, 3);
+    const float32x4_t u2 =
+        vfmaq_laneq_f32(scan(vld1q_f32(x + i + 8)), p0, u1, 3);
+    const float32x4_t u3 =
+        vfmaq_laneq_f32(scan(vld1q_f32(x + i + 12)), p0, u2, 3);
+    vst1q_f32(y + i, vfmaq_f32(u0, p0, carry));
+    vst1q_f32(y + i + 4, vfmaq_f32(u1, p1, carry));
+    vst1q_f32(y + i + 8, vfmaq_f32(u2, p2, carry));
+    const float32x4_t y3 = vfmaq_f32(u3, p3, carry);
+    vst1q_f32(y + i + 12, y3);
+    carry = vdupq_laneq_f32(y3, 3);
+  }
+  state = vgetq_lane_f32(carry, 0);
+#endif
+
+  for (; i < len; i++) {
+    state = x[i] + a * state;
+    y[i] = state;
+  }
+
+  return state;
+}
+
+inline uint32_t XorShift32(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  (*state) = x;
+  return x;
+}
+
+// Uniform in [-0.5, 0.5).
+inline float UniformNoise(uint32_t *state) {
+  return float(XorShift32(state) >> 8) * (1.0f / 16777216.0f) - 0.5f;
+}
+
 }  // namespace
 
 std::vector<float> inv_preemphasis(const float *x, size_t len,
                                    const float scale) {
+  std::vector<float> y(len);
+  inv_preemphasis(x, len, scale, y.data());
+  return y;
+}
+
+float inv_preemphasis(const float *x, const size_t len, const float scale,
+                      float *y, const float state) {
   // scipy.signal.lfilter([1], [1, -hparams.preemphasis], x)
   // =>
   // y[0] = x[0]
@@ -20,41 +365,387 @@ std::vector<float> inv_preemphasis(const float *x, size_t len,
   // ...
   // y[n] = -y[n-1] * (-hparams.preemphasis) + x[n]
   //
+  return InvPreemphasisKernel(x, len, scale, y, state);
+}
+
+void inv_preemphasis_parallel(const float *x, const size_t len,
+                              const float scale, float *y, ThreadPool &pool) {
+  // Below this, waking up the pool costs more than filtering(about 1 ns per
+  // sample).
+  const size_t kMinChunkLength = 1 << 16;
+  const size_t num_chunks = std::min(pool.num_threads(), len / kMinChunkLength);
+  if (num_chunks <= 1) {
+    inv_preemphasis(x, len, scale, y);
+    return;
+  }
 
-  std::vector<float> y;
-  y.push_back(x[0]);
+  // 1. Filter each chunk from zero state in parallel.
+  // 2. Propagate the last output of each chunk(sequential, one per chunk).
+  // 3. Add the response to the true initial state, state * a^(i + 1), to
+  //    each chunk in parallel. For |a| < 1 it decays below the smallest
+  //    normal float within a few thousand samples, so this pass only
+  //    touches the head of each chunk.
+  auto chunk_begin = [&](size_t c) { return (len * c) / num_chunks; };
+  std::vector<float> last(num_chunks, 0.0f);
 
-  for (size_t i = 1; i < len; i++) {
-    y.emplace_back(x[i] + y[i - 1] * scale);
+  pool.parallel_for(num_chunks, [&](size_t first, size_t end, size_t) {
+    for (size_t c = first; c < end; c++) {
+      const size_t begin = chunk_begin(c);
+      last[c] = inv_preemphasis(x + begin, chunk_begin(c + 1) - begin, scale,
+                                y + begin);
+    }
+  });
+
+  std::vector<float> initial(num_chunks, 0.0f);
+  for (size_t c = 1; c < num_chunks; c++) {
+    const size_t n = chunk_begin(c) - chunk_begin(c - 1);
+    initial[c] = last[c - 1] + initial[c - 1] * std::pow(scale, float(n));
   }
 
-  return y;
+  pool.parallel_for(num_chunks, [&](size_t first, size_t end, size_t) {
+    for (size_t c = std::max(size_t(1), first); c < end; c++) {
+      // Stop at denormals: they never round to zero when |a| is close to 1.
+      float response = initial[c] * scale;
+      for (size_t i = chunk_begin(c);
+           (i < chunk_begin(c + 1)) &&
+           (std::fabs(response) >= std::numeric_limits<float>::min());
+           i++) {
+        y[i] += response;
+        response *= scale;
+      }
+    }
+  });
+}
+
+void spectrogram_to_amplitude(const float *spec, const size_t len,
+                              const float min_level_db,
+                              const float ref_level_db, const float power,
+                              float *amp) {
+  // db_to_amp(db) ^ power = 10 ^ (db * power / 20) = 2 ^ (a * x + b)
+  //   db = x * -min_level_db + min_level_db + ref_level_db
+  const float kLog2Of10 = 3.3219280949f;
+  const float c = 0.05f * power * kLog2Of10;
+  const float a = -min_level_db * c;
+  const float b = (min_level_db + ref_level_db) * c;
+
+  size_t i = 0;
+
+#if defined(__AVX2__) && defined(__FMA__)
+  {
+    const __m256 a8 = _mm256_set1_ps(a);
+    const __m256 b8 = _mm256_set1_ps(b);
+    const __m256 zero8 = _mm256_setzero_ps();
+    const __m256 one8 = _mm256_set1_ps(1.0f);
+    for (; i + 8 <= len; i += 8) {
+      const __m256 x =
+          _mm256_min_ps(one8, _mm256_max_ps(zero8, _mm256_loadu_ps(spec + i)));
+      _mm256_storeu_ps(amp + i, Exp2(_mm256_fmadd_ps(a8, x, b8)));
+    }
+  }
+#endif
+
+#if defined(__SSE2__)
+  {
+    const __m128 a4 = _mm_set1_ps(a);
+    const __m128 b4 = _mm_set1_ps(b);
+    const __m128 zero4 = _mm_setzero_ps();
+    const __m128 one4 = _mm_set1_ps(1.0f);
+    for (; i + 4 <= len; i += 4) {
+      const __m128 x =
+          _mm_min_ps(one4, _mm_max_ps(zero4, _mm_loadu_ps(spec + i)));
+      _mm_storeu_ps(amp + i, Exp2(_mm_add_ps(_mm_mul_ps(a4, x), b4)));
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  {
+    const float32x4_t a4 = vdupq_n_f32(a);
+    const float32x4_t b4 = vdupq_n_f32(b);
+    const float32x4_t zero4 = vdupq_n_f32(0.0f);
+    const float32x4_t one4 = vdupq_n_f32(1.0f);
+    for (; i + 4 <= len; i += 4) {
+      const float32x4_t x =
+          vminq_f32(one4, vmaxq_f32(zero4, vld1q_f32(spec + i)));
+      vst1q_f32(amp + i, Exp2(vfmaq_f32(b4, a4, x)));
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    const float x = std::min(1.0f, std::max(0.0f, spec[i]));
+    amp[i] = Exp2(a * x + b);
+  }
+}
+
+void amplitude_power(const float *x, const size_t len, const float power,
+                     float *y) {
+  size_t i = 0;
+
+#if defined(__AVX2__) && defined(__FMA__)
+  {
+    const __m256 p8 = _mm256_set1_ps(power);
+    for (; i + 8 <= len; i += 8) {
+      _mm256_storeu_ps(
+          y + i, Exp2(_mm256_mul_ps(p8, Log2(_mm256_loadu_ps(x + i)))));
+    }
+  }
+#endif
+
+#if defined(__SSE2__)
+  {
+    const __m128 p4 = _mm_set1_ps(power);
+    for (; i + 4 <= len; i += 4) {
+      _mm_storeu_ps(y + i, Exp2(_mm_mul_ps(p4, Log2(_mm_loadu_ps(x + i)))));
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  {
+    const float32x4_t p4 = vdupq_n_f32(power);
+    for (; i + 4 <= len; i += 4) {
+      vst1q_f32(y + i, Exp2(vmulq_f32(p4, Log2(vld1q_f32(x + i)))));
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    y[i] = Exp2(power * Log2(x[i]));
+  }
+}
+
+EndPointDetector::EndPointDetector(const size_t sample_rate,
+                                   const float threshold_db,
+                                   const float min_silence_sec,
+                                   const bool absolute_)
+    : window_length(size_t(float(sample_rate) * min_silence_sec)),
+      hop_length(std::max(size_t(1), window_length / 4)),
+      threshold(db_to_amp(threshold_db)),
+      absolute(absolute_),
+      state(kScanning),
+      position(0),
+      loud_end(0),
+      candidate(hop_length),
+      end(0) {}
+
+void EndPointDetector::reset() {
+  state = kScanning;
+  position = 0;
+  loud_end = 0;
+  candidate = hop_length;
+  end = 0;
+}
+
+size_t EndPointDetector::stable_length() const {
+  if (found()) {
+    return end;
+  }
+  if (window_length == 0) {
+    return position;
+  }
+  // Later candidates only move forward and are never before the last loud
+  // sample, so the end point is at least one hop after both. While speech
+  // continues, this is close to `position`.
+  return std::min(position, std::max(candidate, loud_end) + hop_length);
+}
+
+bool EndPointDetector::push(const float *wav, const size_t len) {
+  if ((state == kFound) || (len == 0)) {
+    return found();
+  }
+
+  if (window_length == 0) {
+    position += len;
+    return false;
+  }
+
+  size_t i = 0;
+  while (i < len) {
+    if (state == kPending) {
+      // The window is silent and is followed by at least one more sample.
+      state = kFound;
+      return true;
+    }
+
+    // Consume samples up to the end of the candidate window.
+    const size_t n = std::min(len - i, candidate + window_length - position);
+    const size_t last = LastLoudSample(wav + i, n, threshold, absolute);
+    if (last < n) {
+      loud_end = position + last + 1;
+    }
+    position += n;
+    i += n;
+
+    if (position == candidate + window_length) {
+      // [candidate, candidate + window_length) is complete.
+      if (loud_end <= candidate) {
+        state = kPending;
+        end = candidate + hop_length;
+      } else {
+        // Skip candidates which still contain the last loud sample.
+        const size_t k = (loud_end - candidate + hop_length - 1) / hop_length;
+        candidate += k * hop_length;
+      }
+    }
+  }
+
+  return false;
 }
 
 size_t find_end_point(const float *wav, const size_t wav_len,
                       const size_t sample_rate, const float threshold_db,
-                      const float min_silence_sec) {
-  const size_t window_length = size_t(sample_rate * min_silence_sec);
-  const size_t hop_length = window_length / 4;
+                      const float min_silence_sec, const bool absolute) {
+  EndPointDetector detector(sample_rate, threshold_db, min_silence_sec,
+                            absolute);
+  detector.push(wav, wav_len);
+  return detector.end_point();
+}
 
-  const float threshold = db_to_amp(threshold_db);
+float peak_amplitude(const float *x, const size_t len) {
+  size_t i = 0;
+  float peak = 0.0f;
 
-  if (window_length > wav_len) {
-    return wav_len;
+#if defined(__SSE2__)
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 m0 = _mm_setzero_ps();
+  __m128 m1 = _mm_setzero_ps();
+  for (; i + 8 <= len; i += 8) {
+    m0 = _mm_max_ps(m0, _mm_and_ps(abs_mask, _mm_loadu_ps(x + i)));
+    m1 = _mm_max_ps(m1, _mm_and_ps(abs_mask, _mm_loadu_ps(x + i + 4)));
+  }
+  m0 = _mm_max_ps(m0, m1);
+  m0 = _mm_max_ps(m0, _mm_shuffle_ps(m0, m0, _MM_SHUFFLE(1, 0, 3, 2)));
+  m0 = _mm_max_ps(m0, _mm_shuffle_ps(m0, m0, _MM_SHUFFLE(2, 3, 0, 1)));
+  peak = _mm_cvtss_f32(m0);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  float32x4_t m0 = vdupq_n_f32(0.0f);
+  float32x4_t m1 = vdupq_n_f32(0.0f);
+  for (; i + 8 <= len; i += 8) {
+    m0 = vmaxq_f32(m0, vabsq_f32(vld1q_f32(x + i)));
+    m1 = vmaxq_f32(m1, vabsq_f32(vld1q_f32(x + i + 4)));
   }
+  peak = vmaxvq_f32(vmaxq_f32(m0, m1));
+#endif
+
+  for (; i < len; i++) {
+    peak = std::max(peak, std::fabs(x[i]));
+  }
+  return peak;
+}
 
-  for (size_t x = hop_length; x < (wav_len - window_length); x += hop_length) {
-    const size_t end_pos = std::min(wav_len, x + window_length);
+void quantize_int16(const float *x, const size_t len, const float scale,
+                    int16_t *y) {
+  size_t i = 0;
 
-    // find maximum for range [x, x + window_length]
-    float m = *(std::max_element(wav + x, wav + end_pos));
-    if (m < threshold) {
-      return std::min(wav_len, x + hop_length);
+#if defined(__SSE2__)
+  // cvtps rounds to nearest even but returns INT32_MIN on overflow(also for
+  // large positive values), so clamp in float first. packs saturates to
+  // int16.
+  const __m128 s = _mm_set1_ps(scale);
+  const __m128 lo = _mm_set1_ps(-32768.0f);
+  const __m128 hi = _mm_set1_ps(32767.0f);
+  for (; i + 8 <= len; i += 8) {
+    const __m128 va = _mm_mul_ps(_mm_loadu_ps(x + i), s);
+    const __m128 vb = _mm_mul_ps(_mm_loadu_ps(x + i + 4), s);
+    const __m128i a = _mm_cvtps_epi32(_mm_min_ps(hi, _mm_max_ps(lo, va)));
+    const __m128i b = _mm_cvtps_epi32(_mm_min_ps(hi, _mm_max_ps(lo, vb)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(y + i),
+                     _mm_packs_epi32(a, b));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  for (; i + 8 <= len; i += 8) {
+    const int32x4_t a = vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(x + i), scale));
+    const int32x4_t b =
+        vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(x + i + 4), scale));
+    vst1q_s16(y + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+  }
+#endif
+
+  for (; i < len; i++) {
+    const float v =
+        std::min(32767.0f, std::max(-32768.0f, std::nearbyint(x[i] * scale)));
+    y[i] = int16_t(v);
+  }
+}
+
+DitheredQuantizer::DitheredQuantizer(const bool noise_shaping_,
+                                     const uint32_t seed)
+    : noise_shaping(noise_shaping_), error(0.0f) {
+  // Decorrelate the lanes. xorshift32 must not start from 0.
+  uint32_t s = (seed != 0) ? seed : 1;
+  for (int k = 0; k < 4; k++) {
+    s = s * 1664525u + 1013904223u;
+    rng[k] = (s != 0) ? s : 1;
+  }
+}
+
+void DitheredQuantizer::quantize(const float *x, const size_t len,
+                                 const float scale, int16_t *y) {
+  size_t i = 0;
+
+  if (noise_shaping) {
+    for (; i < len; i++) {
+      const float dither = UniformNoise(&rng[0]) + UniformNoise(&rng[1]);
+      const float v = x[i] * scale - error;
+      const float q = std::min(
+          32767.0f, std::max(-32768.0f, std::nearbyint(v + dither)));
+      // Limit feedback on clipping so the loop stays stable.
+      error = std::min(1.0f, std::max(-1.0f, q - v));
+      y[i] = int16_t(q);
     }
+    return;
   }
 
-  // No silence duration found.
-  return wav_len;
+#if defined(__SSE2__)
+  // Same xorshift32 on 4 lanes.
+  __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rng));
+  auto next = [&r]() {
+    r = _mm_xor_si128(r, _mm_slli_epi32(r, 13));
+    r = _mm_xor_si128(r, _mm_srli_epi32(r, 17));
+    r = _mm_xor_si128(r, _mm_slli_epi32(r, 5));
+    return _mm_sub_ps(
+        _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(r, 8)),
+                   _mm_set1_ps(1.0f / 16777216.0f)),
+        _mm_set1_ps(0.5f));
+  };
+  const __m128 s = _mm_set1_ps(scale);
+  const __m128 lo = _mm_set1_ps(-32768.0f);
+  const __m128 hi = _mm_set1_ps(32767.0f);
+  for (; i + 8 <= len; i += 8) {
+    __m128 va = _mm_mul_ps(_mm_loadu_ps(x + i), s);
+    va = _mm_add_ps(va, _mm_add_ps(next(), next()));
+    __m128 vb = _mm_mul_ps(_mm_loadu_ps(x + i + 4), s);
+    vb = _mm_add_ps(vb, _mm_add_ps(next(), next()));
+    const __m128i a = _mm_cvtps_epi32(_mm_min_ps(hi, _mm_max_ps(lo, va)));
+    const __m128i b = _mm_cvtps_epi32(_mm_min_ps(hi, _mm_max_ps(lo, vb)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(y + i),
+                     _mm_packs_epi32(a, b));
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(rng), r);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  uint32x4_t r = vld1q_u32(rng);
+  auto next = [&r]() {
+    r = veorq_u32(r, vshlq_n_u32(r, 13));
+    r = veorq_u32(r, vshrq_n_u32(r, 17));
+    r = veorq_u32(r, vshlq_n_u32(r, 5));
+    return vsubq_f32(vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(r, 8)),
+                                 1.0f / 16777216.0f),
+                     vdupq_n_f32(0.5f));
+  };
+  for (; i + 8 <= len; i += 8) {
+    const float32x4_t va = vaddq_f32(vmulq_n_f32(vld1q_f32(x + i), scale),
+                                     vaddq_f32(next(), next()));
+    const float32x4_t vb = vaddq_f32(vmulq_n_f32(vld1q_f32(x + i + 4), scale),
+                                     vaddq_f32(next(), next()));
+    vst1q_s16(y + i, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(va)),
+                                  vqmovn_s32(vcvtnq_s32_f32(vb))));
+  }
+  vst1q_u32(rng, r);
+#endif
+
+  for (; i < len; i++) {
+    const float dither = UniformNoise(&rng[0]) + UniformNoise(&rng[1]);
+    const float v = std::min(
+        32767.0f, std::max(-32768.0f, std::nearbyint(x[i] * scale + dither)));
+    y[i] = int16_t(v);
+  }
 }
 
 }  // namespace tts
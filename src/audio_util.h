@@ -1,22 +1,158 @@
 #ifndef AUDIO_UTIL_H_
 #define AUDIO_UTIL_H_
 
+#include <cstdint>
 #include <cstdlib>
 #include <vector>
 
 namespace tts {
 
+class ThreadPool;
+
 std::vector<float> inv_preemphasis(const float *x, const size_t len,
                                    const float scale);
 
+//
+// Inverse preemphasis into a caller provided buffer(SIMD block prefix
+// scan). y[n] = x[n] + scale * y[n - 1], y[-1] = `state`.
+// `x` and `y` can be the same buffer(in-place).
+// @return y[len - 1], the state for the next chunk of the same stream.
+//
+float inv_preemphasis(const float *x, const size_t len, const float scale,
+                      float *y, const float state = 0.0f);
+
+//
+// Multithreaded inverse preemphasis for long audio(e.g. minutes) on
+// `pool`. Falls back to single thread for short audio.
+// `x` and `y` can be the same buffer.
+//
+void inv_preemphasis_parallel(const float *x, const size_t len,
+                              const float scale, float *y, ThreadPool &pool);
+
+//
+// Convert normalized spectrogram(Tacotron output) to linear amplitude.
+// Same as keithito's tacotron:
+//   amp = db_to_amp(denormalize(spec) + ref_level_db) ^ power
+//   denormalize(x) = clip(x, 0, 1) * -min_level_db + min_level_db
+// Computed as a single SIMD polynomial exp2 per bin
+// (relative error < 1.5e-6).
+// `spec` and `amp` can be the same buffer.
+//
+void spectrogram_to_amplitude(const float *spec, const size_t len,
+                              const float min_level_db,
+                              const float ref_level_db, const float power,
+                              float *amp);
+
+//
+// y = x ^ power with SIMD polynomial log2/exp2(relative error < 4e-6).
+// `x` must be positive(e.g. output of mel to linear conversion).
+// `x` and `y` can be the same buffer.
+//
+void amplitude_power(const float *x, const size_t len, const float power,
+                     float *y);
+
+//
+// @return max(|x[i]|). 0 for empty input.
+//
+float peak_amplitude(const float *x, const size_t len);
+
+//
+// y = clamp(round(x * scale), -32768, 32767)(SIMD, saturating pack).
+//
+void quantize_int16(const float *x, const size_t len, const float scale,
+                    int16_t *y);
+
+//
+// int16 quantizer with TPDF dither(sum of two independent uniform values,
+// +-1 LSB peak), which makes the quantization error independent of the
+// signal(no harmonic distortion on quiet passages).
+//
+// With `noise_shaping`, the quantization error is fed back(first order,
+// e[n - 1] subtracted before quantization), which moves the noise from low
+// frequencies, where speech has most of its energy, towards Nyquist
+// (noise spectrum shaped by |1 - e^-jw|^2). The error feedback is a
+// recurrence, so this mode is scalar; plain TPDF is SIMD.
+//
+// Random generator and error state are kept across calls, so audio can be
+// quantized in chunks.
+//
+class DitheredQuantizer {
+ public:
+  explicit DitheredQuantizer(const bool noise_shaping = false,
+                             const uint32_t seed = 1);
+
+  void quantize(const float *x, const size_t len, const float scale,
+                int16_t *y);
+
+ private:
+  bool noise_shaping;
+  uint32_t rng[4];  // xorshift32 state for each SIMD lane
+  float error;      // last quantization error(noise shaping)
+};
+
 //
 // Find end point of audio by detecting silence duration.
+// Windows of `min_silence_sec` are tested every quarter window, and the
+// audio is cut one hop after the start of the first window whose samples
+// are all below `threshold_db`. When `absolute` is true, |sample| is
+// compared instead of the signed sample.
+// Single pass: each sample is read at most once.
 // @return End frame index.
 //
 size_t find_end_point(const float *wav, const size_t wav_len,
                       const size_t sample_rate,
                       const float threshold_db = -40.0f,
-                      const float min_silence_sec = 0.8f);
+                      const float min_silence_sec = 0.8f,
+                      const bool absolute = false);
+
+//
+// Streaming version of `find_end_point`. Audio is given in chunks of any
+// size, and the end point is the same as `find_end_point` for the
+// concatenated audio.
+//
+class EndPointDetector {
+ public:
+  EndPointDetector(const size_t sample_rate,
+                   const float threshold_db = -40.0f,
+                   const float min_silence_sec = 0.8f,
+                   const bool absolute = false);
+
+  //
+  // Feed next chunk of audio.
+  // @return true once the end point is found. Later chunks are ignored.
+  //
+  bool push(const float *wav, const size_t len);
+
+  bool found() const { return state == kFound; }
+
+  //
+  // @return End frame index if found, otherwise the number of samples
+  // pushed so far(i.e. no silence to remove).
+  //
+  size_t end_point() const { return found() ? end : position; }
+
+  //
+  // Samples before this index are kept whatever audio follows, i.e. they
+  // can be output before the end point is known.
+  //
+  size_t stable_length() const;
+
+  void reset();
+
+ private:
+  enum State { kScanning, kPending, kFound };
+
+  size_t window_length;
+  size_t hop_length;
+  float threshold;
+  bool absolute;
+
+  State state;
+  size_t position;   // The number of samples pushed.
+  size_t loud_end;   // (Index of the last loud sample) + 1. 0 if none.
+  size_t candidate;  // Start of the window to test next.
+  size_t end;
+};
 
 }  // namespace tts
 
@@ -0,0 +1,236 @@
+#include "audio_writer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include "audio_util.h"
+#include "g711.h"
+
+namespace tts {
+
+namespace {
+
+// RIFF/WAVE header without extra chunks.
+const size_t kWavHeaderSize = 44;
+
+const uint16_t kWaveFormatPcm = 1;
+const uint16_t kWaveFormatIeeeFloat = 3;
+const uint16_t kWaveFormatALaw = 6;
+const uint16_t kWaveFormatMuLaw = 7;
+
+void PutU16(uint8_t* p, uint16_t v) {
+  p[0] = uint8_t(v & 0xff);
+  p[1] = uint8_t(v >> 8);
+}
+
+void PutU32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = uint8_t((v >> (8 * i)) & 0xff);
+  }
+}
+
+void MakeWavHeader(uint16_t format_tag, uint16_t bits_per_sample,
+                   uint32_t sample_rate, uint32_t data_size,
+                   uint8_t* header) {
+  const uint16_t block_align = bits_per_sample / 8;
+  std::memcpy(header, "RIFF", 4);
+  PutU32(header + 4, (data_size > 0xffffffffu - 36) ? 0xffffffffu
+                                                     : data_size + 36);
+  std::memcpy(header + 8, "WAVE", 4);
+  std::memcpy(header + 12, "fmt ", 4);
+  PutU32(header + 16, 16);
+  PutU16(header + 20, format_tag);
+  PutU16(header + 22, 1);  // mono
+  PutU32(header + 24, sample_rate);
+  PutU32(header + 28, sample_rate * block_align);
+  PutU16(header + 32, block_align);
+  PutU16(header + 34, bits_per_sample);
+  std::memcpy(header + 36, "data", 4);
+  PutU32(header + 40, data_size);
+}
+
+}  // namespace
+
+class AudioWriter::Impl {
+ public:
+  explicit Impl(const AudioWriterConfig& config_)
+      : config(config_),
+        fp(nullptr),
+        is_stdout(false),
+        num_samples(0),
+        quantizer(config_.noise_shaping) {}
+
+  ~Impl() { close(); }
+
+  bool open(const std::string& filename) {
+    close();
+
+    if (filename == "-") {
+#ifdef _WIN32
+      _setmode(_fileno(stdout), _O_BINARY);
+#endif
+      fp = stdout;
+      is_stdout = true;
+    } else {
+      fp = std::fopen(filename.c_str(), "wb");
+      is_stdout = false;
+      if (!fp) {
+        std::cerr << "Failed to open file for writing : " << filename
+                  << std::endl;
+        return false;
+      }
+    }
+    num_samples = 0;
+
+    if (config.wav_header) {
+      // The length is not known yet.
+      const uint32_t max_size = 0xffffffffu - 36;
+      return write_header(max_size - max_size % uint32_t(bytes_per_sample()));
+    }
+    return true;
+  }
+
+  bool write(const float* samples, size_t n, float gain) {
+    if (!fp) {
+      return false;
+    }
+    if (n == 0) {
+      return true;
+    }
+
+    const void* data = samples;
+    if (config.format != kSampleFormatFloat32) {
+      pcm.resize(n);
+      const float scale = 32767.0f * gain;
+      if (config.dither && (config.format == kSampleFormatPcm16)) {
+        quantizer.quantize(samples, n, scale, pcm.data());
+      } else {
+        quantize_int16(samples, n, scale, pcm.data());
+      }
+      data = pcm.data();
+
+      if (config.format == kSampleFormatMuLaw) {
+        encoded.resize(n);
+        encode_mulaw(pcm.data(), n, encoded.data());
+        data = encoded.data();
+      } else if (config.format == kSampleFormatALaw) {
+        encoded.resize(n);
+        encode_alaw(pcm.data(), n, encoded.data());
+        data = encoded.data();
+      }
+    } else {
+      // Always scaled: the cost is negligible next to the file write.
+      scaled.resize(n);
+      for (size_t i = 0; i < n; i++) {
+        scaled[i] = samples[i] * gain;
+      }
+      data = scaled.data();
+    }
+
+    if (std::fwrite(data, bytes_per_sample(), n, fp) != n) {
+      std::cerr << "Failed to write audio" << std::endl;
+      return false;
+    }
+    num_samples += n;
+
+    // Hand the chunk to the consumer now.
+    return std::fflush(fp) == 0;
+  }
+
+  bool close() {
+    if (!fp) {
+      return true;
+    }
+
+    bool ret = true;
+    // Write the actual sizes when the output is seekable. Pipes and stdout
+    // keep the maximum length, which readers treat as "until end of stream".
+    if (config.wav_header && !is_stdout &&
+        (std::fseek(fp, 0, SEEK_SET) == 0)) {
+      const uint64_t data_size = num_samples * bytes_per_sample();
+      ret = write_header(uint32_t(std::min(data_size, uint64_t(0xffffffffu))));
+    }
+
+    if (is_stdout) {
+      ret = (std::fflush(fp) == 0) && ret;
+    } else {
+      ret = (std::fclose(fp) == 0) && ret;
+    }
+    fp = nullptr;
+    return ret;
+  }
+
+  AudioWriterConfig config;
+  FILE* fp;
+  bool is_stdout;
+  uint64_t num_samples;
+
+ private:
+  size_t bytes_per_sample() const {
+    switch (config.format) {
+      case kSampleFormatPcm16:
+        return 2;
+      case kSampleFormatFloat32:
+        return 4;
+      default:
+        return 1;  // G.711
+    }
+  }
+
+  uint16_t format_tag() const {
+    switch (config.format) {
+      case kSampleFormatFloat32:
+        return kWaveFormatIeeeFloat;
+      case kSampleFormatMuLaw:
+        return kWaveFormatMuLaw;
+      case kSampleFormatALaw:
+        return kWaveFormatALaw;
+      default:
+        return kWaveFormatPcm;
+    }
+  }
+
+  bool write_header(uint32_t data_size) {
+    uint8_t header[kWavHeaderSize];
+    MakeWavHeader(format_tag(), uint16_t(bytes_per_sample() * 8),
+                  uint32_t(config.sample_rate), data_size, header);
+    if (std::fwrite(header, 1, kWavHeaderSize, fp) != kWavHeaderSize) {
+      std::cerr << "Failed to write WAV header" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  DitheredQuantizer quantizer;
+  std::vector<int16_t> pcm;
+  std::vector<float> scaled;
+  std::vector<uint8_t> encoded;
+};
+
+AudioWriter::AudioWriter(const AudioWriterConfig& config)
+    : impl(new Impl(config)) {}
+
+AudioWriter::~AudioWriter() {}
+
+bool AudioWriter::open(const std::string& filename) {
+  return impl->open(filename);
+}
+
+bool AudioWriter::write(const float* samples, size_t num_samples,
+                        float gain) {
+  return impl->write(samples, num_samples, gain);
+}
+
+bool AudioWriter::close() { return impl->close(); }
+
+uint64_t AudioWriter::num_samples() const { return impl->num_samples; }
+
+}  // namespace tts
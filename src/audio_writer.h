@@ -0,0 +1,78 @@
+#ifndef AUDIO_WRITER_H_
+#define AUDIO_WRITER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace tts {
+
+enum SampleFormat {
+  kSampleFormatPcm16 = 0,  // signed 16bit PCM
+  kSampleFormatFloat32,    // 32bit IEEE float
+  kSampleFormatMuLaw,      // 8bit G.711 mu-law
+  kSampleFormatALaw,       // 8bit G.711 A-law
+};
+
+class AudioWriterConfig {
+ public:
+  AudioWriterConfig()
+      : sample_rate(20000),
+        format(kSampleFormatPcm16),
+        wav_header(true),
+        dither(false),
+        noise_shaping(false) {}
+
+  int sample_rate;
+  SampleFormat format;
+
+  // false = headerless raw samples(little endian).
+  bool wav_header;
+
+  // TPDF dither / noise shaping for 16bit PCM(see `DitheredQuantizer`).
+  // Ignored for G.711, whose quantization steps are much coarser than the
+  // dither.
+  bool dither;
+  bool noise_shaping;
+};
+
+///
+/// Streaming audio output to a file, a FIFO or stdout. Samples are written
+/// and flushed as soon as they are given, so a consumer(e.g. media server
+/// reading a pipe) can start playing before synthesis finishes.
+///
+/// The total length is unknown when the WAV header is written, so the
+/// header declares the maximum length. When the output is seekable(regular
+/// file), the actual sizes are written on `close()`.
+///
+class AudioWriter {
+ public:
+  explicit AudioWriter(const AudioWriterConfig& config);
+  ~AudioWriter();
+
+  ///
+  /// @param[in] filename Output filename. "-" = stdout.
+  ///
+  bool open(const std::string& filename);
+
+  ///
+  /// Write samples multiplied by `gain`(full scale = 1.0).
+  ///
+  bool write(const float* samples, size_t num_samples, float gain = 1.0f);
+
+  ///
+  /// Flush and close. Called by the destructor if not called.
+  ///
+  bool close();
+
+  uint64_t num_samples() const;
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl;
+};
+
+}  // namespace tts
+
+#endif  // AUDIO_WRITER_H_
@@ -0,0 +1,230 @@
+#include "batch_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "tf_synthesizer.h"
+
+namespace tts {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Request {
+  std::vector<int32_t> sequence;
+  std::promise<SynthesisResult> promise;
+  Clock::time_point submit_time;
+};
+
+void SetFailed(std::promise<SynthesisResult>* promise) {
+  SynthesisResult result;
+  result.ok = false;
+  promise->set_value(std::move(result));
+}
+
+}  // namespace
+
+class BatchScheduler::Impl {
+ public:
+  Impl(TensorflowSynthesizer* synthesizer_, const BatchSchedulerConfig& config_)
+      : synthesizer(synthesizer_),
+        config(config_),
+        max_wait(std::chrono::milliseconds(std::max(0, config_.max_wait_ms))),
+        stopped(false),
+        // +1 for the overflow bucket.
+        buckets(config_.bucket_boundaries.size() + 1) {
+    config.max_batch_size = std::max(size_t(1), config.max_batch_size);
+    std::sort(config.bucket_boundaries.begin(), config.bucket_boundaries.end());
+
+    const int num_workers = std::max(1, config.num_workers);
+    for (int i = 0; i < num_workers; i++) {
+      workers.emplace_back(&Impl::worker, this);
+    }
+  }
+
+  ~Impl() { shutdown(); }
+
+  std::future<SynthesisResult> submit(const std::vector<int32_t>& sequence) {
+    Request req;
+    req.sequence = sequence;
+    req.submit_time = Clock::now();
+    std::future<SynthesisResult> future = req.promise.get_future();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopped || sequence.empty()) {
+        SetFailed(&req.promise);
+        return future;
+      }
+      buckets[bucket_index(sequence.size())].push_back(std::move(req));
+    }
+    cv.notify_one();
+
+    return future;
+  }
+
+  void shutdown() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopped = true;
+    }
+    cv.notify_all();
+
+    for (auto& worker : workers) {
+      if (worker.joinable()) {
+        worker.join();
+      }
+    }
+    workers.clear();
+  }
+
+ private:
+  size_t bucket_index(size_t length) const {
+    const std::vector<size_t>& boundaries = config.bucket_boundaries;
+    return size_t(std::lower_bound(boundaries.begin(), boundaries.end(),
+                                   length) -
+                  boundaries.begin());
+  }
+
+  // Pick a bucket to dispatch. Must be called with `mutex` held.
+  // Expired buckets(oldest request first) take priority over full buckets.
+  // When nothing is ready, returns false and the earliest deadline of pending
+  // requests to `deadline`(if any).
+  bool take_batch(const Clock::time_point now, std::vector<Request>* batch,
+                  bool* has_deadline, Clock::time_point* deadline) {
+    *has_deadline = false;
+
+    std::deque<Request>* expired = nullptr;
+    std::deque<Request>* full = nullptr;
+    for (auto& bucket : buckets) {
+      if (bucket.empty()) {
+        continue;
+      }
+
+      const Clock::time_point d = bucket.front().submit_time + max_wait;
+      if (stopped || (d <= now)) {
+        if (!expired || (bucket.front().submit_time <
+                         expired->front().submit_time)) {
+          expired = &bucket;
+        }
+      } else if (!full && (bucket.size() >= config.max_batch_size)) {
+        full = &bucket;
+      }
+
+      if (!(*has_deadline) || (d < *deadline)) {
+        *deadline = d;
+        *has_deadline = true;
+      }
+    }
+
+    std::deque<Request>* bucket = expired ? expired : full;
+    if (!bucket) {
+      return false;
+    }
+
+    const size_t n = std::min(bucket->size(), config.max_batch_size);
+    batch->clear();
+    for (size_t i = 0; i < n; i++) {
+      batch->push_back(std::move(bucket->front()));
+      bucket->pop_front();
+    }
+
+    return true;
+  }
+
+  bool has_pending() const {
+    for (const auto& bucket : buckets) {
+      if (!bucket.empty()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void worker() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      std::vector<Request> batch;
+      bool has_deadline = false;
+      Clock::time_point deadline;
+
+      if (take_batch(Clock::now(), &batch, &has_deadline, &deadline)) {
+        const bool more = has_pending();
+        lock.unlock();
+        if (more) {
+          // Let another worker pick up the remaining buckets.
+          cv.notify_one();
+        }
+        dispatch(&batch);
+        lock.lock();
+        continue;
+      }
+
+      if (stopped && !has_pending()) {
+        break;
+      }
+
+      if (has_deadline) {
+        cv.wait_until(lock, deadline);
+      } else {
+        cv.wait(lock);
+      }
+    }
+  }
+
+  void dispatch(std::vector<Request>* batch) {
+    std::vector<std::vector<int32_t>> sequences(batch->size());
+    for (size_t i = 0; i < batch->size(); i++) {
+      sequences[i].swap((*batch)[i].sequence);
+    }
+
+    std::vector<std::vector<float>> outputs;
+    if (!synthesizer->synthesize(sequences, &outputs) ||
+        (outputs.size() != batch->size())) {
+      std::cerr << "Failed to synthesize a batch of " << batch->size()
+                << " sequences." << std::endl;
+      for (auto& req : *batch) {
+        SetFailed(&req.promise);
+      }
+      return;
+    }
+
+    for (size_t i = 0; i < batch->size(); i++) {
+      SynthesisResult result;
+      result.ok = true;
+      result.wav.swap(outputs[i]);
+      (*batch)[i].promise.set_value(std::move(result));
+    }
+  }
+
+  TensorflowSynthesizer* synthesizer;
+  BatchSchedulerConfig config;
+  const Clock::duration max_wait;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopped;
+  std::vector<std::deque<Request>> buckets;
+  std::vector<std::thread> workers;
+};
+
+BatchScheduler::BatchScheduler(TensorflowSynthesizer* synthesizer,
+                               const BatchSchedulerConfig& config)
+    : impl(new Impl(synthesizer, config)) {}
+
+BatchScheduler::~BatchScheduler() {}
+
+std::future<SynthesisResult> BatchScheduler::submit(
+    const std::vector<int32_t>& sequence) {
+  return impl->submit(sequence);
+}
+
+void BatchScheduler::shutdown() { impl->shutdown(); }
+
+}  // namespace tts
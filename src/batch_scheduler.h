@@ -0,0 +1,88 @@
+#ifndef BATCH_SCHEDULER_H_
+#define BATCH_SCHEDULER_H_
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace tts {
+
+class TensorflowSynthesizer;
+
+class BatchSchedulerConfig {
+ public:
+  BatchSchedulerConfig()
+      : max_batch_size(8),
+        max_wait_ms(20),
+        num_workers(1),
+        bucket_boundaries({32, 64, 96, 128, 192, 256}) {}
+
+  // Dispatch a bucket as soon as it has this many sequences.
+  size_t max_batch_size;
+
+  // Dispatch a (non-full) bucket when its oldest sequence has waited this
+  // long.
+  int max_wait_ms;
+
+  // The number of threads calling `TensorflowSynthesizer::synthesize`
+  // concurrently.
+  int num_workers;
+
+  // Upper bound(inclusive) of sequence length(T_in) for each bucket, in
+  // ascending order. Sequences longer than the last boundary go to an extra
+  // overflow bucket.
+  std::vector<size_t> bucket_boundaries;
+};
+
+struct SynthesisResult {
+  SynthesisResult() : ok(false) {}
+
+  bool ok;
+  std::vector<float> wav;
+};
+
+///
+/// Dynamic batching scheduler in front of `TensorflowSynthesizer`.
+///
+/// Incoming sequences are grouped into buckets by its length so that padding
+/// waste in a batch is small. A bucket is dispatched as a batch when it
+/// becomes full or when `max_wait_ms` elapsed since its oldest request was
+/// submitted.
+///
+class BatchScheduler {
+ public:
+  ///
+  /// @param[in] synthesizer Loaded synthesizer. Must outlive the scheduler.
+  ///
+  BatchScheduler(TensorflowSynthesizer* synthesizer,
+                 const BatchSchedulerConfig& config);
+
+  ///
+  /// Flushes pending requests and stops worker threads.
+  ///
+  ~BatchScheduler();
+
+  ///
+  /// Submit a sequence for synthesis. Thread-safe.
+  ///
+  /// @return Future of synthesized audio. `wav` has the length of the longest
+  /// utterance in the batch it was dispatched with, so apply
+  /// `find_end_point` to remove trailing silence.
+  ///
+  std::future<SynthesisResult> submit(const std::vector<int32_t>& sequence);
+
+  ///
+  /// Dispatch all pending requests and stop worker threads. Requests
+  /// submitted after shutdown fail immediately.
+  ///
+  void shutdown();
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl;
+};
+
+}  // namespace tts
+
+#endif  // BATCH_SCHEDULER_H_
@@ -0,0 +1,221 @@
+#include "fft.h"
+
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "object_cache.h"
+
+namespace tts {
+
+namespace {
+
+bool IsPowerOfTwo(size_t n) { return (n != 0) && ((n & (n - 1)) == 0); }
+
+//
+// Radix-2 butterflies of one block in split format.
+//   t = w[j] * b[j], b[j] = a[j] - t, a[j] = a[j] + t   (j = [0, h))
+//
+void Butterfly(float* ar, float* ai, float* br, float* bi, const float* wc,
+               const float* ws, size_t h) {
+  size_t j = 0;
+
+#if defined(__AVX__)
+  for (; j + 8 <= h; j += 8) {
+    const __m256 c = _mm256_loadu_ps(wc + j);
+    const __m256 s = _mm256_loadu_ps(ws + j);
+    const __m256 xr = _mm256_loadu_ps(br + j);
+    const __m256 xi = _mm256_loadu_ps(bi + j);
+#if defined(__FMA__)
+    const __m256 tr = _mm256_fmsub_ps(c, xr, _mm256_mul_ps(s, xi));
+    const __m256 ti = _mm256_fmadd_ps(c, xi, _mm256_mul_ps(s, xr));
+#else
+    const __m256 tr = _mm256_sub_ps(_mm256_mul_ps(c, xr), _mm256_mul_ps(s, xi));
+    const __m256 ti = _mm256_add_ps(_mm256_mul_ps(c, xi), _mm256_mul_ps(s, xr));
+#endif
+    const __m256 yr = _mm256_loadu_ps(ar + j);
+    const __m256 yi = _mm256_loadu_ps(ai + j);
+    _mm256_storeu_ps(br + j, _mm256_sub_ps(yr, tr));
+    _mm256_storeu_ps(bi + j, _mm256_sub_ps(yi, ti));
+    _mm256_storeu_ps(ar + j, _mm256_add_ps(yr, tr));
+    _mm256_storeu_ps(ai + j, _mm256_add_ps(yi, ti));
+  }
+#endif
+
+#if defined(__SSE2__)
+  for (; j + 4 <= h; j += 4) {
+    const __m128 c = _mm_loadu_ps(wc + j);
+    const __m128 s = _mm_loadu_ps(ws + j);
+    const __m128 xr = _mm_loadu_ps(br + j);
+    const __m128 xi = _mm_loadu_ps(bi + j);
+    const __m128 tr = _mm_sub_ps(_mm_mul_ps(c, xr), _mm_mul_ps(s, xi));
+    const __m128 ti = _mm_add_ps(_mm_mul_ps(c, xi), _mm_mul_ps(s, xr));
+    const __m128 yr = _mm_loadu_ps(ar + j);
+    const __m128 yi = _mm_loadu_ps(ai + j);
+    _mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+    _mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+    _mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+    _mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+  }
+#elif defined(__ARM_NEON)
+  for (; j + 4 <= h; j += 4) {
+    const float32x4_t c = vld1q_f32(wc + j);
+    const float32x4_t s = vld1q_f32(ws + j);
+    const float32x4_t xr = vld1q_f32(br + j);
+    const float32x4_t xi = vld1q_f32(bi + j);
+    const float32x4_t tr = vmlsq_f32(vmulq_f32(c, xr), s, xi);
+    const float32x4_t ti = vmlaq_f32(vmulq_f32(c, xi), s, xr);
+    const float32x4_t yr = vld1q_f32(ar + j);
+    const float32x4_t yi = vld1q_f32(ai + j);
+    vst1q_f32(br + j, vsubq_f32(yr, tr));
+    vst1q_f32(bi + j, vsubq_f32(yi, ti));
+    vst1q_f32(ar + j, vaddq_f32(yr, tr));
+    vst1q_f32(ai + j, vaddq_f32(yi, ti));
+  }
+#endif
+
+  for (; j < h; j++) {
+    const float tr = wc[j] * br[j] - ws[j] * bi[j];
+    const float ti = wc[j] * bi[j] + ws[j] * br[j];
+    br[j] = ar[j] - tr;
+    bi[j] = ai[j] - ti;
+    ar[j] += tr;
+    ai[j] += ti;
+  }
+}
+
+}  // namespace
+
+RealFFT::RealFFT(size_t n_) : n(n_), m(n_ / 2) {
+  const double kPi = 3.14159265358979323846;
+
+  size_t log2m = 0;
+  while ((size_t(1) << log2m) < m) {
+    log2m++;
+  }
+
+  bitrev.resize(m);
+  for (size_t i = 0; i < m; i++) {
+    size_t r = 0;
+    for (size_t b = 0; b < log2m; b++) {
+      r |= ((i >> b) & 1) << (log2m - 1 - b);
+    }
+    bitrev[i] = r;
+  }
+
+  stage_cos.resize(m - 1);
+  stage_sin.resize(m - 1);
+  for (size_t h = 1; h < m; h <<= 1) {
+    for (size_t j = 0; j < h; j++) {
+      const double theta = -kPi * double(j) / double(h);
+      stage_cos[h - 1 + j] = float(std::cos(theta));
+      stage_sin[h - 1 + j] = float(std::sin(theta));
+    }
+  }
+
+  post_cos.resize(m + 1);
+  post_sin.resize(m + 1);
+  for (size_t k = 0; k <= m; k++) {
+    const double theta = -2.0 * kPi * double(k) / double(n);
+    post_cos[k] = float(std::cos(theta));
+    post_sin[k] = float(std::sin(theta));
+  }
+}
+
+void RealFFT::complex_fft(float* zr, float* zi) const {
+  // First stage(h = 1) has a trivial twiddle(w = 1).
+  for (size_t i = 0; i + 1 < m; i += 2) {
+    const float tr = zr[i + 1];
+    const float ti = zi[i + 1];
+    zr[i + 1] = zr[i] - tr;
+    zi[i + 1] = zi[i] - ti;
+    zr[i] += tr;
+    zi[i] += ti;
+  }
+
+  for (size_t h = 2; h < m; h <<= 1) {
+    const float* wc = &stage_cos[h - 1];
+    const float* ws = &stage_sin[h - 1];
+    for (size_t i = 0; i < m; i += 2 * h) {
+      Butterfly(zr + i, zi + i, zr + i + h, zi + i + h, wc, ws, h);
+    }
+  }
+}
+
+void RealFFT::forward(const float* x, float* re, float* im,
+                      float* work) const {
+  float* zr = work;
+  float* zi = work + m;
+
+  // Pack even/odd samples into a complex signal of half length.
+  for (size_t j = 0; j < m; j++) {
+    const size_t r = bitrev[j];
+    zr[j] = x[2 * r];
+    zi[j] = x[2 * r + 1];
+  }
+
+  complex_fft(zr, zi);
+
+  // Split into the spectrum of the real signal.
+  for (size_t k = 0; k <= m; k++) {
+    const size_t k0 = (k == m) ? 0 : k;
+    const size_t k1 = (k == 0) ? 0 : (m - k);
+
+    const float er = 0.5f * (zr[k0] + zr[k1]);
+    const float ei = 0.5f * (zi[k0] - zi[k1]);
+    const float or_ = 0.5f * (zi[k0] + zi[k1]);
+    const float oi = -0.5f * (zr[k0] - zr[k1]);
+
+    re[k] = er + post_cos[k] * or_ - post_sin[k] * oi;
+    im[k] = ei + post_cos[k] * oi + post_sin[k] * or_;
+  }
+}
+
+void RealFFT::inverse(const float* re, const float* im, float* x,
+                      float* work) const {
+  float* zr = work;
+  float* zi = work + m;
+
+  for (size_t k = 0; k < m; k++) {
+    const float re0 = re[k];
+    const float im0 = (k == 0) ? 0.0f : im[k];
+    const float re1 = re[m - k];
+    const float im1 = (k == 0) ? 0.0f : im[m - k];
+
+    const float er = 0.5f * (re0 + re1);
+    const float ei = 0.5f * (im0 - im1);
+    const float dr = re0 - re1;
+    const float di = im0 + im1;
+    const float or_ = 0.5f * (dr * post_cos[k] + di * post_sin[k]);
+    const float oi = 0.5f * (di * post_cos[k] - dr * post_sin[k]);
+
+    // Store conj(E + iO) in bit reversed order, so that forward FFT computes
+    // the inverse FFT(up to conjugation and scaling).
+    const size_t r = bitrev[k];
+    zr[r] = er - oi;
+    zi[r] = -(ei + or_);
+  }
+
+  complex_fft(zr, zi);
+
+  const float scale = 1.0f / float(m);
+  for (size_t j = 0; j < m; j++) {
+    x[2 * j] = zr[j] * scale;
+    x[2 * j + 1] = -zi[j] * scale;
+  }
+}
+
+std::shared_ptr<const RealFFT> GetRealFFT(size_t n) {
+  if (!IsPowerOfTwo(n) || (n < 4)) {
+    return nullptr;
+  }
+
+  static auto* cache = new ObjectCache<size_t, RealFFT>();
+  return cache->get(n, [n]() { return std::make_shared<const RealFFT>(n); });
+}
+
+}  // namespace tts
@@ -0,0 +1,72 @@
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace tts {
+
+///
+/// Real FFT plan for power-of-two length `n`.
+/// Twiddle factors and bit reversal indices are computed once at
+/// construction, so a plan can be shared(read-only) across threads and
+/// requests. Use `GetRealFFT` to get a cached plan.
+///
+/// Spectrum is stored in split format: `re[0..n/2]` and `im[0..n/2]`.
+///
+class RealFFT {
+ public:
+  explicit RealFFT(size_t n);
+
+  size_t size() const { return n; }
+
+  // The number of frequency bins(n / 2 + 1).
+  size_t num_bins() const { return n / 2 + 1; }
+
+  ///
+  /// Forward transform. Same as numpy.fft.rfft.
+  ///
+  /// @param[in] x Input signal. `n` samples.
+  /// @param[out] re Real part. `n/2+1` elements.
+  /// @param[out] im Imaginary part. `n/2+1` elements.
+  /// @param[in] work Scratch buffer. `n` floats.
+  ///
+  void forward(const float* x, float* re, float* im, float* work) const;
+
+  ///
+  /// Inverse transform(scaled by 1/n). Same as numpy.fft.irfft.
+  /// Imaginary part of DC and Nyquist bins is ignored.
+  ///
+  /// @param[in] re Real part. `n/2+1` elements.
+  /// @param[in] im Imaginary part. `n/2+1` elements.
+  /// @param[out] x Output signal. `n` samples.
+  /// @param[in] work Scratch buffer. `n` floats.
+  ///
+  void inverse(const float* re, const float* im, float* x, float* work) const;
+
+ private:
+  // In-place complex FFT of size n/2 on bit-reversed split input.
+  void complex_fft(float* zr, float* zi) const;
+
+  size_t n;
+  size_t m;  // n / 2
+
+  std::vector<size_t> bitrev;  // [m]
+
+  // Twiddles for each radix-2 stage(stage with half size h starts at h - 1).
+  std::vector<float> stage_cos, stage_sin;  // [m - 1]
+
+  // exp(-2 pi i k / n), k = [0, m]
+  std::vector<float> post_cos, post_sin;
+};
+
+///
+/// Returns a cached plan for length `n`(power of two, >= 4).
+/// Returns nullptr when `n` is not supported. Thread-safe.
+///
+std::shared_ptr<const RealFFT> GetRealFFT(size_t n);
+
+}  // namespace tts
+
+#endif  // FFT_H_
@@ -0,0 +1,143 @@
+#include "g711.h"
+
+#include <array>
+
+namespace tts {
+
+namespace {
+
+const int kSignBit = 0x80;
+const int kQuantMask = 0x0f;
+const int kSegShift = 4;
+const int kSegMask = 0x70;
+
+// mu-law works on 14bit magnitude, A-law on 13bit.
+const int kMuLawBias = 0x84;
+const int kMuLawClip = 8159;
+
+const int kMuLawSegEnd[8] = {0x3f,  0x7f,  0xff,  0x1ff,
+                             0x3ff, 0x7ff, 0xfff, 0x1fff};
+const int kALawSegEnd[8] = {0x1f, 0x3f, 0x7f,  0xff,
+                            0x1ff, 0x3ff, 0x7ff, 0xfff};
+
+int Segment(int value, const int* seg_end) {
+  for (int i = 0; i < 8; i++) {
+    if (value <= seg_end[i]) {
+      return i;
+    }
+  }
+  return 8;
+}
+
+// Tables indexed by the upper bits of the sample as unsigned, i.e.
+// (uint16_t(x) >> 2) for mu-law and (uint16_t(x) >> 3) for A-law.
+// std::array: trivially destructible, so nothing is destroyed at exit.
+const std::array<uint8_t, (1 << 14)>& MuLawTable() {
+  static const std::array<uint8_t, (1 << 14)> table = []() {
+    std::array<uint8_t, (1 << 14)> t;
+    for (size_t i = 0; i < t.size(); i++) {
+      t[i] = linear_to_mulaw(int16_t(uint16_t(i << 2)));
+    }
+    return t;
+  }();
+  return table;
+}
+
+const std::array<uint8_t, (1 << 13)>& ALawTable() {
+  static const std::array<uint8_t, (1 << 13)> table = []() {
+    std::array<uint8_t, (1 << 13)> t;
+    for (size_t i = 0; i < t.size(); i++) {
+      t[i] = linear_to_alaw(int16_t(uint16_t(i << 3)));
+    }
+    return t;
+  }();
+  return table;
+}
+
+}  // namespace
+
+uint8_t linear_to_mulaw(int16_t pcm) {
+  int value = pcm >> 2;
+  int mask;
+  if (value < 0) {
+    value = -value;
+    mask = 0x7f;
+  } else {
+    mask = 0xff;
+  }
+  if (value > kMuLawClip) {
+    value = kMuLawClip;
+  }
+  value += (kMuLawBias >> 2);
+
+  const int seg = Segment(value, kMuLawSegEnd);
+  if (seg >= 8) {
+    return uint8_t(0x7f ^ mask);
+  }
+  const int u = (seg << 4) | ((value >> (seg + 1)) & 0xf);
+  return uint8_t(u ^ mask);
+}
+
+uint8_t linear_to_alaw(int16_t pcm) {
+  int value = pcm >> 3;
+  int mask;
+  if (value >= 0) {
+    mask = 0xd5;
+  } else {
+    mask = 0x55;
+    value = -value - 1;
+  }
+
+  const int seg = Segment(value, kALawSegEnd);
+  if (seg >= 8) {
+    return uint8_t(0x7f ^ mask);
+  }
+  int a = seg << kSegShift;
+  if (seg < 2) {
+    a |= (value >> 1) & kQuantMask;
+  } else {
+    a |= (value >> seg) & kQuantMask;
+  }
+  return uint8_t(a ^ mask);
+}
+
+int16_t mulaw_to_linear(uint8_t u) {
+  const int v = ~u & 0xff;
+  int t = ((v & kQuantMask) << 3) + kMuLawBias;
+  t <<= (v & kSegMask) >> kSegShift;
+  return int16_t((v & kSignBit) ? (kMuLawBias - t) : (t - kMuLawBias));
+}
+
+int16_t alaw_to_linear(uint8_t a) {
+  const int v = a ^ 0x55;
+  int t = (v & kQuantMask) << 4;
+  const int seg = (v & kSegMask) >> kSegShift;
+  switch (seg) {
+    case 0:
+      t += 8;
+      break;
+    case 1:
+      t += 0x108;
+      break;
+    default:
+      t += 0x108;
+      t <<= seg - 1;
+  }
+  return int16_t((v & kSignBit) ? t : -t);
+}
+
+void encode_mulaw(const int16_t* x, size_t len, uint8_t* y) {
+  const uint8_t* table = MuLawTable().data();
+  for (size_t i = 0; i < len; i++) {
+    y[i] = table[uint16_t(x[i]) >> 2];
+  }
+}
+
+void encode_alaw(const int16_t* x, size_t len, uint8_t* y) {
+  const uint8_t* table = ALawTable().data();
+  for (size_t i = 0; i < len; i++) {
+    y[i] = table[uint16_t(x[i]) >> 3];
+  }
+}
+
+}  // namespace tts
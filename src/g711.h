@@ -0,0 +1,30 @@
+#ifndef G711_H_
+#define G711_H_
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace tts {
+
+///
+/// G.711 mu-law/A-law encoding of 16bit PCM for telephony(8kHz).
+///
+/// Encoding uses lookup tables indexed by the significant bits of the
+/// sample(14 bits for mu-law, 13 bits for A-law), built once from the
+/// reference segment search(ITU-T G.711, same as Sun's g711.c). Output is
+/// bit-identical to the reference.
+///
+void encode_mulaw(const int16_t* x, size_t len, uint8_t* y);
+void encode_alaw(const int16_t* x, size_t len, uint8_t* y);
+
+///
+/// Reference(non table) conversions of a single sample.
+///
+uint8_t linear_to_mulaw(int16_t pcm);
+uint8_t linear_to_alaw(int16_t pcm);
+int16_t mulaw_to_linear(uint8_t u);
+int16_t alaw_to_linear(uint8_t a);
+
+}  // namespace tts
+
+#endif  // G711_H_
@@ -0,0 +1,352 @@
+#include "griffin_lim.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace tts {
+
+namespace {
+
+// `_griffin_lim_tensorflow` uses tf.maximum(1e-8, tf.abs(est)).
+constexpr float kMinMagnitude = 1e-8f;
+
+//
+// Replace the magnitude of a complex spectrum while keeping its phase.
+// (re, im) = mag * (re, im) / max(eps, |(re, im)|)
+//
+void ApplyMagnitude(const float* mag, float* re, float* im, size_t n) {
+  size_t i = 0;
+
+#if defined(__AVX__)
+  const __m256 eps8 = _mm256_set1_ps(kMinMagnitude);
+  for (; i + 8 <= n; i += 8) {
+    const __m256 r = _mm256_loadu_ps(re + i);
+    const __m256 m = _mm256_loadu_ps(im + i);
+    const __m256 abs = _mm256_sqrt_ps(
+        _mm256_add_ps(_mm256_mul_ps(r, r), _mm256_mul_ps(m, m)));
+    const __m256 scale =
+        _mm256_div_ps(_mm256_loadu_ps(mag + i), _mm256_max_ps(abs, eps8));
+    _mm256_storeu_ps(re + i, _mm256_mul_ps(r, scale));
+    _mm256_storeu_ps(im + i, _mm256_mul_ps(m, scale));
+  }
+#endif
+
+#if defined(__SSE2__)
+  const __m128 eps4 = _mm_set1_ps(kMinMagnitude);
+  for (; i + 4 <= n; i += 4) {
+    const __m128 r = _mm_loadu_ps(re + i);
+    const __m128 m = _mm_loadu_ps(im + i);
+    const __m128 abs =
+        _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)));
+    const __m128 scale =
+        _mm_div_ps(_mm_loadu_ps(mag + i), _mm_max_ps(abs, eps4));
+    _mm_storeu_ps(re + i, _mm_mul_ps(r, scale));
+    _mm_storeu_ps(im + i, _mm_mul_ps(m, scale));
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t eps4 = vdupq_n_f32(kMinMagnitude);
+  for (; i + 4 <= n; i += 4) {
+    const float32x4_t r = vld1q_f32(re + i);
+    const float32x4_t m = vld1q_f32(im + i);
+    const float32x4_t abs = vsqrtq_f32(vmlaq_f32(vmulq_f32(r, r), m, m));
+    const float32x4_t scale =
+        vdivq_f32(vld1q_f32(mag + i), vmaxq_f32(abs, eps4));
+    vst1q_f32(re + i, vmulq_f32(r, scale));
+    vst1q_f32(im + i, vmulq_f32(m, scale));
+  }
+#endif
+
+  for (; i < n; i++) {
+    const float abs = std::sqrt(re[i] * re[i] + im[i] * im[i]);
+    const float scale = mag[i] / std::max(abs, kMinMagnitude);
+    re[i] *= scale;
+    im[i] *= scale;
+  }
+}
+
+}  // namespace
+
+GriffinLim::GriffinLim(const GriffinLimConfig& config_)
+    : config(config_), pool(config_.num_threads) {
+  stft = GetStft(
+      StftConfig(config.n_fft, config.hop_length, config.win_length));
+  if (!stft) {
+    std::cerr << "Failed to setup STFT for Griffin-Lim." << std::endl;
+    return;
+  }
+
+  scratch.resize(pool.num_threads());
+  for (auto& s : scratch) {
+    s.ws = StftWorkspace(*stft);
+    s.re.resize(stft->num_bins());
+    s.im.resize(stft->num_bins());
+  }
+}
+
+void GriffinLim::process_frames(const float* magnitude, const float* wav,
+                                size_t begin, size_t end, size_t chunk,
+                                bool initial) {
+  Scratch& s = scratch[chunk];
+  const size_t num_bins = stft->num_bins();
+
+  for (size_t t = begin; t < end; t++) {
+    const float* mag = magnitude + t * num_bins;
+
+    if (initial) {
+      // Zero phase.
+      std::memcpy(s.re.data(), mag, sizeof(float) * num_bins);
+      std::fill(s.im.begin(), s.im.end(), 0.0f);
+    } else {
+      stft->forward(wav + t * config.hop_length, s.re.data(), s.im.data(),
+                    &s.ws);
+
+      if (config.track_convergence) {
+        for (size_t k = 0; k < num_bins; k++) {
+          const double x =
+              std::sqrt(double(s.re[k]) * double(s.re[k]) +
+                        double(s.im[k]) * double(s.im[k]));
+          s.xx += x * x;
+          s.xs += x * double(mag[k]);
+          s.ss += double(mag[k]) * double(mag[k]);
+        }
+      }
+
+      if (config.momentum > 0.0f) {
+        apply_momentum(s.re.data(), s.im.data(), t);
+      }
+
+      ApplyMagnitude(mag, s.re.data(), s.im.data(), num_bins);
+    }
+
+    stft->inverse(s.re.data(), s.im.data(), &frames[t * config.win_length],
+                  &s.ws);
+  }
+}
+
+void GriffinLim::apply_momentum(float* re, float* im, size_t t) {
+  // Same formulation as librosa.griffinlim:
+  //   angles = rebuilt - (momentum / (1 + momentum)) * rebuilt_prev
+  const float alpha = config.momentum / (1.0f + config.momentum);
+  const size_t num_bins = stft->num_bins();
+  float* pr = &prev_re[t * num_bins];
+  float* pi = &prev_im[t * num_bins];
+
+  for (size_t k = 0; k < num_bins; k++) {
+    const float r = re[k];
+    const float i = im[k];
+    re[k] = r - alpha * pr[k];
+    im[k] = i - alpha * pi[k];
+    pr[k] = r;
+    pi[k] = i;
+  }
+}
+
+bool GriffinLim::run(const float* magnitude, size_t num_frames,
+                     std::vector<float>* wav) {
+  return run(magnitude, num_frames, config.iterations, wav);
+}
+
+bool GriffinLim::run(const float* magnitude, size_t num_frames,
+                     int iterations, std::vector<float>* wav) {
+  if (!valid()) {
+    return false;
+  }
+
+  if (num_frames == 0) {
+    std::cerr << "Empty spectrogram." << std::endl;
+    return false;
+  }
+
+  const size_t length = stft->signal_length(num_frames);
+  wav->resize(length);
+  frames.resize(num_frames * config.win_length);
+
+  if (config.momentum > 0.0f) {
+    prev_re.assign(num_frames * stft->num_bins(), 0.0f);
+    prev_im.assign(num_frames * stft->num_bins(), 0.0f);
+  }
+
+  convergence_history.clear();
+
+  float* y = wav->data();
+
+  for (int iter = -1; iter < iterations; iter++) {
+    const bool initial = (iter < 0);
+
+    for (auto& s : scratch) {
+      s.xx = s.xs = s.ss = 0.0;
+    }
+
+    pool.parallel_for(num_frames, [&](size_t begin, size_t end, size_t chunk) {
+      process_frames(magnitude, y, begin, end, chunk, initial);
+    });
+
+    if (config.track_convergence && !initial) {
+      double xx = 0.0, xs = 0.0, ss = 0.0;
+      for (const auto& s : scratch) {
+        xx += s.xx;
+        xs += s.xs;
+        ss += s.ss;
+      }
+      // min_a |a x - s|^2 = ss - xs^2 / xx
+      const double err = (xx > 0.0) ? (ss - xs * xs / xx) : ss;
+      convergence_history.push_back(
+          (ss > 0.0) ? std::sqrt(std::max(0.0, err) / ss) : 0.0);
+    }
+
+    pool.parallel_for(length, [&](size_t begin, size_t end, size_t) {
+      stft->overlap_add(frames.data(), num_frames, begin, end, false, y);
+    });
+  }
+
+  return true;
+}
+
+RtisiLa::RtisiLa(const RtisiLaConfig& config_, const Callback& callback_)
+    : config(config_), callback(callback_), first_active(0), base(0) {
+  stft = GetStft(
+      StftConfig(config.n_fft, config.hop_length, config.win_length));
+  if (!stft) {
+    std::cerr << "Failed to setup STFT for RTISI-LA." << std::endl;
+    return;
+  }
+
+  ws = StftWorkspace(*stft);
+  buf.resize(config.win_length);
+  re.resize(stft->num_bins());
+  im.resize(stft->num_bins());
+}
+
+void RtisiLa::estimate(size_t index) {
+  const size_t hop = config.hop_length;
+  const size_t win_length = config.win_length;
+  const size_t offset = index * hop;
+
+  // Committed frames.
+  std::memcpy(buf.data(), &committed[offset - base],
+              sizeof(float) * win_length);
+
+  // Active frames(including the frame itself).
+  for (size_t a = 0; a < active.size(); a++) {
+    const size_t a_offset = (first_active + a) * hop;
+    if ((a_offset >= offset + win_length) ||
+        (a_offset + win_length <= offset)) {
+      continue;
+    }
+    const size_t s0 = std::max(offset, a_offset);
+    const size_t s1 = std::min(offset, a_offset) + win_length;
+    const float* src = &active[a].signal[s0 - a_offset];
+    float* dst = &buf[s0 - offset];
+    for (size_t i = 0; i < s1 - s0; i++) {
+      dst[i] += src[i];
+    }
+  }
+}
+
+void RtisiLa::update(size_t i) {
+  const size_t win_length = config.win_length;
+  Frame& frame = active[i];
+
+  estimate(first_active + i);
+
+  float peak = 0.0f;
+  for (size_t k = 0; k < win_length; k++) {
+    peak = std::max(peak, std::fabs(buf[k]));
+  }
+
+  if (!(peak > 0.0f)) {
+    // No estimate yet(e.g. the first frame). Use zero phase, same as
+    // `GriffinLim`'s initial phase.
+    std::copy(frame.magnitude.begin(), frame.magnitude.end(), re.begin());
+    std::fill(im.begin(), im.end(), 0.0f);
+  } else {
+    stft->forward(buf.data(), re.data(), im.data(), &ws);
+    ApplyMagnitude(frame.magnitude.data(), re.data(), im.data(),
+                   stft->num_bins());
+  }
+
+  stft->inverse(re.data(), im.data(), frame.signal.data(), &ws);
+}
+
+void RtisiLa::commit_oldest() {
+  const size_t hop = config.hop_length;
+  const size_t win_length = config.win_length;
+
+  const size_t offset = first_active * hop;
+  const Frame& frame = active.front();
+  float* dst = &committed[offset - base];
+  for (size_t k = 0; k < win_length; k++) {
+    dst[k] += frame.signal[k];
+  }
+
+  active.pop_front();
+  first_active++;
+
+  // Samples before the next frame are final.
+  const size_t final_end = first_active * hop;
+  if (final_end > base) {
+    const size_t n = final_end - base;
+    callback(committed.data(), n);
+    committed.erase(committed.begin(), committed.begin() + long(n));
+    base = final_end;
+  }
+}
+
+bool RtisiLa::push_frame(const float* magnitude) {
+  if (!valid()) {
+    return false;
+  }
+
+  const size_t index = first_active + active.size();
+
+  Frame frame;
+  frame.magnitude.assign(magnitude, magnitude + stft->num_bins());
+  frame.signal.assign(config.win_length, 0.0f);
+  active.push_back(std::move(frame));
+
+  // Make room for the new frame.
+  const size_t end = index * config.hop_length + config.win_length;
+  if (end - base > committed.size()) {
+    committed.resize(end - base, 0.0f);
+  }
+
+  // Initial phase of the new frame from the partial reconstruction.
+  update(active.size() - 1);
+
+  for (int iter = 0; iter < config.iterations; iter++) {
+    for (size_t i = 0; i < active.size(); i++) {
+      update(i);
+    }
+  }
+
+  if (active.size() > config.lookahead) {
+    commit_oldest();
+  }
+
+  return true;
+}
+
+void RtisiLa::finish() {
+  while (!active.empty()) {
+    commit_oldest();
+  }
+
+  // No more frames overlap the tail of the last frame.
+  if (!committed.empty()) {
+    callback(committed.data(), committed.size());
+  }
+
+  committed.clear();
+  first_active = 0;
+  base = 0;
+}
+
+}  // namespace tts
@@ -0,0 +1,211 @@
+#ifndef GRIFFIN_LIM_H_
+#define GRIFFIN_LIM_H_
+
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "stft.h"
+#include "thread_pool.h"
+
+namespace tts {
+
+class GriffinLimConfig {
+ public:
+  // Defaults are keithito's tacotron hparams at 20kHz
+  // (num_freq = 1025, frame_shift_ms = 12.5, frame_length_ms = 50).
+  GriffinLimConfig()
+      : n_fft(2048),
+        hop_length(250),
+        win_length(1000),
+        iterations(60),
+        momentum(0.0f),
+        num_threads(0),
+        track_convergence(false) {}
+
+  // FFT length. Must be power of two.
+  size_t n_fft;
+  size_t hop_length;
+  // Hann window length(<= n_fft).
+  size_t win_length;
+  int iterations;
+
+  // Momentum of fast Griffin-Lim(Perraudin et al. 2013). 0 = classic
+  // Griffin-Lim. 0.99 is a typical value for fast Griffin-Lim, which reaches
+  // the quality of classic Griffin-Lim in fewer iterations.
+  float momentum;
+
+  // 0 = hardware concurrency.
+  size_t num_threads;
+
+  // Record spectral convergence of each iteration(see `convergence()`).
+  bool track_convergence;
+};
+
+///
+/// Native Griffin-Lim phase reconstruction.
+///
+/// Follows the in-graph implementation of keithito's tacotron
+/// (`_griffin_lim_tensorflow`): zero initial phase, non-centered STFT with
+/// periodic Hann window, and inverse STFT by windowed overlap-add without
+/// normalization. So the output can be fed to `inv_preemphasis` just like
+/// `model/griffinlim/Squeeze`.
+///
+/// Frames are processed in parallel. The STFT(FFT plan and window) is shared
+/// through `GetStft`, and work buffers are kept in the object and reused
+/// across calls, so create one instance per thread.
+///
+class GriffinLim {
+ public:
+  explicit GriffinLim(const GriffinLimConfig& config);
+
+  ///
+  /// @return false when the configuration is invalid.
+  ///
+  bool valid() const { return stft != nullptr; }
+
+  ///
+  /// @param[in] magnitude Linear amplitude spectrogram(already raised to the
+  /// power). Shape = [num_frames, n_fft / 2 + 1].
+  /// @param[in] num_frames The number of frames.
+  /// @param[out] wav Reconstructed waveform.
+  /// Length = (num_frames - 1) * hop_length + win_length.
+  ///
+  bool run(const float* magnitude, size_t num_frames, std::vector<float>* wav);
+
+  ///
+  /// Same as above, but overrides the number of iterations for this call.
+  ///
+  bool run(const float* magnitude, size_t num_frames, int iterations,
+           std::vector<float>* wav);
+
+  ///
+  /// Spectral convergence(scale invariant) of the waveform estimated before
+  /// each iteration of the last `run()`:
+  ///   min_a || a |STFT(y)| - S || / || S ||
+  /// Only recorded when `track_convergence` is set.
+  ///
+  const std::vector<double>& convergence() const { return convergence_history; }
+
+ private:
+  // Analysis(STFT of `wav`), projection onto `magnitude` and synthesis
+  // (windowed inverse FFT) of frames [begin, end).
+  void process_frames(const float* magnitude, const float* wav, size_t begin,
+                      size_t end, size_t chunk, bool initial);
+
+  // Fast Griffin-Lim: (re, im) -= alpha * prev, prev = rebuilt.
+  void apply_momentum(float* re, float* im, size_t t);
+
+  GriffinLimConfig config;
+  std::shared_ptr<const Stft> stft;
+  ThreadPool pool;
+
+  // Windowed time domain frames. [num_frames, win_length]
+  std::vector<float> frames;
+
+  // STFT of the previous estimate for fast Griffin-Lim.
+  // [num_frames, n_fft / 2 + 1]
+  std::vector<float> prev_re, prev_im;
+
+  // Per thread scratch buffers.
+  struct Scratch {
+    StftWorkspace ws;
+    std::vector<float> re, im;
+    // Accumulators for spectral convergence.
+    double xx, xs, ss;
+  };
+  std::vector<Scratch> scratch;
+
+  std::vector<double> convergence_history;
+};
+
+class RtisiLaConfig {
+ public:
+  RtisiLaConfig()
+      : n_fft(2048),
+        hop_length(250),
+        win_length(1000),
+        lookahead(3),
+        iterations(4) {}
+
+  size_t n_fft;
+  size_t hop_length;
+  size_t win_length;
+
+  // The number of future frames used to refine a frame before its samples
+  // are emitted. Latency = (lookahead + 1) * hop_length samples(+ window).
+  size_t lookahead;
+
+  // Refinement iterations over the look-ahead frames per pushed frame.
+  int iterations;
+};
+
+///
+/// Streaming phase reconstruction(Real-Time Iterative Spectrogram Inversion
+/// with Look-Ahead, Zhu et al. 2007).
+///
+/// Magnitude frames are pushed one by one. Each new frame's phase is
+/// initialized from the partial reconstruction, then the frames in the
+/// look-ahead window are refined. When a frame leaves the window it is
+/// committed and the samples no later frame overlaps are emitted through the
+/// callback, so the first audio is available after `lookahead + 1` frames
+/// instead of the whole spectrogram.
+///
+/// Uses the same STFT convention and overlap-add scaling as `GriffinLim`.
+///
+class RtisiLa {
+ public:
+  typedef std::function<void(const float* samples, size_t num_samples)>
+      Callback;
+
+  RtisiLa(const RtisiLaConfig& config, const Callback& callback);
+
+  bool valid() const { return stft != nullptr; }
+
+  ///
+  /// @param[in] magnitude Linear amplitude of one frame. n_fft / 2 + 1 bins.
+  ///
+  bool push_frame(const float* magnitude);
+
+  ///
+  /// Commit all remaining frames and emit the rest of the samples. The object
+  /// can be reused for a new utterance after this call.
+  ///
+  void finish();
+
+ private:
+  struct Frame {
+    std::vector<float> magnitude;
+    std::vector<float> signal;  // windowed time domain frame
+  };
+
+  // Current estimate of the samples of frame `index` into `buf`.
+  void estimate(size_t index);
+
+  // Re-estimate phase of i'th active frame.
+  void update(size_t i);
+
+  // Move the oldest active frame to the committed signal and emit samples
+  // which are not overlapped by later frames.
+  void commit_oldest();
+
+  RtisiLaConfig config;
+  Callback callback;
+  std::shared_ptr<const Stft> stft;
+
+  std::deque<Frame> active;
+  size_t first_active;  // frame index of `active.front()`
+
+  // Overlap-added committed frames. committed[i] = sample(base + i).
+  std::vector<float> committed;
+  size_t base;
+
+  StftWorkspace ws;
+  std::vector<float> buf, re, im;
+};
+
+}  // namespace tts
+
+#endif  // GRIFFIN_LIM_H_
@@ -1,6 +1,11 @@
+#include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
 
 #ifdef __clang__
 #pragma clang diagnostic push
@@ -18,14 +23,61 @@
 #pragma clang diagnostic pop
 #endif
 
+#include "audio_writer.h"
+#include "griffin_lim.h"
+#include "mel_inversion.h"
+#include "pipeline.h"
+#include "post_processor.h"
+#include "resampler.h"
+#include "thread_pool.h"
 #include "tf_synthesizer.h"
+#include "wavernn.h"
 
 class HyperParameters
 {
   public:
-    HyperParameters() : preemphasis(0.97f) {};
+    HyperParameters()
+      : preemphasis(0.97f),
+        sample_rate(20000),
+        num_freq(1025),
+        num_mels(80),
+        frame_shift_ms(12.5f),
+        frame_length_ms(50.0f),
+        min_level_db(-100.0f),
+        ref_level_db(20.0f),
+        power(1.5f),
+        griffin_lim_iters(60),
+        griffin_lim_momentum(0.0f),
+        rtisi_lookahead(3),
+        rtisi_iters(4),
+        vocoder_threads(0),
+        output_sample_rate(0) {};
 
     float preemphasis;
+
+    // Audio/spectrogram parameters(same as keithito's tacotron hparams).
+    int sample_rate;
+    int num_freq;
+    int num_mels;
+    float frame_shift_ms;
+    float frame_length_ms;
+    float min_level_db;
+    float ref_level_db;
+    float power;
+    int griffin_lim_iters;
+    // > 0 : fast Griffin-Lim(e.g. 0.99)
+    float griffin_lim_momentum;
+    // Streaming vocoder(RTISI-LA)
+    int rtisi_lookahead;
+    int rtisi_iters;
+    // Thread budget of the native vocoder stage(0 = all cores). Reduce it to
+    // leave cores for the model stage running concurrently.
+    int vocoder_threads;
+    // Sample rate of output WAV(0 = same as sample_rate).
+    int output_sample_rate;
+
+    // TensorFlow session threading/affinity.
+    tts::SynthesizerConfig session;
 };
 
 template<typename T>
@@ -56,8 +108,9 @@ bool GetNumberArray(const nlohmann::json &j, const std::string &name,
 }
 
 
-// Load sequence from JSON array
-bool LoadSequence(const std::string &sequence_filename, std::vector<int32_t> *sequence)
+// Load sequences from JSON. "sequence" is a single utterance and
+// "sequences"(array of arrays) is a multi-sentence document.
+bool LoadSequences(const std::string &sequence_filename, std::vector<std::vector<int32_t>> *sequences)
 {
   std::ifstream is(sequence_filename);
   if (!is) {
@@ -68,8 +121,49 @@ bool LoadSequence(const std::string &sequence_filename, std::vector<int32_t> *se
   nlohmann::json j;
   is >> j;
 
-  return GetNumberArray(j, "sequence", sequence);
+  sequences->clear();
+
+  if (!j.count("sequences")) {
+    std::vector<int32_t> sequence;
+    if (!GetNumberArray(j, "sequence", &sequence)) {
+      return false;
+    }
+    sequences->push_back(sequence);
+    return true;
+  }
+
+  if (!j.at("sequences").is_array()) {
+    std::cerr << "Property is not an array type : sequences" << std::endl;
+    return false;
+  }
 
+  for (auto &element : j.at("sequences")) {
+    nlohmann::json item;
+    item["sequence"] = element;
+    std::vector<int32_t> sequence;
+    if (!GetNumberArray(item, "sequence", &sequence)) {
+      return false;
+    }
+    sequences->push_back(sequence);
+  }
+
+  if (sequences->empty()) {
+    std::cerr << "Empty sequences" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+// Set a number property to `value` if exists.
+template<typename T>
+void GetNumber(const nlohmann::json &j, const std::string &name, T *value) {
+  if (j.count(name)) {
+    auto param = j[name];
+    if (param.is_number()) {
+      (*value) = static_cast<T>(param.get<double>());
+    }
+  }
 }
 
 bool ParseHyperPrameters(const std::string &json_filename, HyperParameters *hparams)
@@ -90,53 +184,357 @@ bool ParseHyperPrameters(const std::string &json_filename, HyperParameters *hpar
     }
   }
 
+  GetNumber(j, "sample_rate", &hparams->sample_rate);
+  GetNumber(j, "num_freq", &hparams->num_freq);
+  GetNumber(j, "num_mels", &hparams->num_mels);
+  GetNumber(j, "frame_shift_ms", &hparams->frame_shift_ms);
+  GetNumber(j, "frame_length_ms", &hparams->frame_length_ms);
+  GetNumber(j, "min_level_db", &hparams->min_level_db);
+  GetNumber(j, "ref_level_db", &hparams->ref_level_db);
+  GetNumber(j, "power", &hparams->power);
+  GetNumber(j, "griffin_lim_iters", &hparams->griffin_lim_iters);
+  GetNumber(j, "griffin_lim_momentum", &hparams->griffin_lim_momentum);
+  GetNumber(j, "rtisi_lookahead", &hparams->rtisi_lookahead);
+  GetNumber(j, "rtisi_iters", &hparams->rtisi_iters);
+  GetNumber(j, "vocoder_threads", &hparams->vocoder_threads);
+  GetNumber(j, "output_sample_rate", &hparams->output_sample_rate);
+
+  GetNumber(j, "intra_op_threads", &hparams->session.intra_op_threads);
+  GetNumber(j, "inter_op_threads", &hparams->session.inter_op_threads);
+
+  if (j.count("use_per_session_threads")) {
+    auto param = j["use_per_session_threads"];
+    if (param.is_boolean()) {
+      hparams->session.use_per_session_threads = param.get<bool>();
+    }
+  }
+
+  if (j.count("cpu_affinity")) {
+    if (!GetNumberArray(j, "cpu_affinity", &hparams->session.cpu_affinity)) {
+      return false;
+    }
+  }
+
+  if (j.count("warmup_lengths")) {
+    if (!GetNumberArray(j, "warmup_lengths", &hparams->session.warmup_lengths)) {
+      return false;
+    }
+  }
+
   return true;
 }
 
+// Parse comma separated list of non-negative integers(e.g. "0,1,2,3").
+bool ParseIntList(const std::string &str, std::vector<int> *values)
+{
+  values->clear();
+
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    char *end = nullptr;
+    long value = std::strtol(item.c_str(), &end, 10);
+    if (item.empty() || (*end != '\0') || (value < 0)) {
+      std::cerr << "Invalid integer list : " << str << std::endl;
+      return false;
+    }
+    values->push_back(int(value));
+  }
+
+  return !values->empty();
+}
+
 void PrintHyperParameters(const HyperParameters &hparams)
 {
   std::cout << "Hyper parameter and configurations :\n";
   std::cout << "  preemphasis : " << hparams.preemphasis << "\n";
+  std::cout << "  sample_rate : " << hparams.sample_rate << "\n";
+  std::cout << "  num_freq : " << hparams.num_freq << "\n";
+  std::cout << "  num_mels : " << hparams.num_mels << "\n";
+  std::cout << "  frame_shift_ms : " << hparams.frame_shift_ms << "\n";
+  std::cout << "  frame_length_ms : " << hparams.frame_length_ms << "\n";
+  std::cout << "  min_level_db : " << hparams.min_level_db << "\n";
+  std::cout << "  ref_level_db : " << hparams.ref_level_db << "\n";
+  std::cout << "  power : " << hparams.power << "\n";
+  std::cout << "  griffin_lim_iters : " << hparams.griffin_lim_iters << "\n";
+  std::cout << "  griffin_lim_momentum : " << hparams.griffin_lim_momentum << "\n";
+  std::cout << "  rtisi_lookahead : " << hparams.rtisi_lookahead << "\n";
+  std::cout << "  rtisi_iters : " << hparams.rtisi_iters << "\n";
+  std::cout << "  vocoder_threads : " << hparams.vocoder_threads << "\n";
+  std::cout << "  output_sample_rate : " << hparams.output_sample_rate << "\n";
+}
+
+// When the model and vocoder stages of the pipeline overlap, TensorFlow's
+// default(0 = all cores) and native Griffin-Lim's default(0 = all cores) would
+// both claim every core. Split the cores between them unless the user gave
+// explicit values. RTISI-LA and WaveRNN run on one core.
+void SplitThreadBudget(const std::string &vocoder, HyperParameters *hparams)
+{
+  int &intra_op_threads = hparams->session.intra_op_threads;
+  int &vocoder_threads = hparams->vocoder_threads;
+  const bool multithreaded_vocoder = (vocoder == "griffin_lim");
+  if ((intra_op_threads > 0) && (!multithreaded_vocoder || (vocoder_threads > 0))) {
+    return;
+  }
+
+  int num_cores = hparams->session.cpu_affinity.empty() ? int(std::thread::hardware_concurrency())
+                                                        : int(hparams->session.cpu_affinity.size());
+  if (num_cores <= 0) {
+    std::cerr << "Warning: Could not detect the number of cores. Model and vocoder stages may oversubscribe "
+                 "cores. Set --intra_op_threads and --vocoder_threads."
+              << std::endl;
+    return;
+  }
+
+  if (intra_op_threads <= 0) {
+    int vocoder_cores = 1;
+    if (multithreaded_vocoder) {
+      vocoder_cores = (vocoder_threads > 0) ? vocoder_threads : num_cores / 2;
+    }
+    intra_op_threads = std::max(1, num_cores - vocoder_cores);
+  }
+
+  if (multithreaded_vocoder && (vocoder_threads <= 0)) {
+    vocoder_threads = std::max(1, num_cores - intra_op_threads);
+  }
+
+  std::cout << "Split " << num_cores << " cores between pipeline stages : intra_op_threads " << intra_op_threads;
+  if (multithreaded_vocoder) {
+    std::cout << ", vocoder_threads " << vocoder_threads;
+  }
+  std::cout << std::endl;
+}
+
+tts::GriffinLimConfig GetGriffinLimConfig(const HyperParameters &hparams)
+{
+  tts::GriffinLimConfig config;
+  config.n_fft = size_t(hparams.num_freq - 1) * 2;
+  config.hop_length = size_t(hparams.frame_shift_ms / 1000.0f * float(hparams.sample_rate));
+  config.win_length = size_t(hparams.frame_length_ms / 1000.0f * float(hparams.sample_rate));
+  config.iterations = hparams.griffin_lim_iters;
+  config.momentum = hparams.griffin_lim_momentum;
+  config.num_threads = size_t(std::max(0, hparams.vocoder_threads));
+  return config;
+}
+
+// Convert a normalized linear spectrogram(shape = [T, num_freq] or
+// [1, T, num_freq]) to linear amplitude. When `mel` is true, the input is a
+// normalized mel spectrogram([T, num_mels]) and is converted to linear
+// amplitude with the pseudo-inverse of the mel filterbank first.
+bool GetMagnitude(const tts::TensorView &spectrogram, const HyperParameters &hparams,
+                  bool mel, std::vector<float> *magnitude, size_t *num_frames)
+{
+  const tts::TensorView spec = (spectrogram.shape().size() == 3) ? spectrogram.slice(0) : spectrogram;
+  const int num_channels = mel ? hparams.num_mels : hparams.num_freq;
+  if ((spec.shape().size() != 2) || (spec.shape()[1] != num_channels)) {
+    std::cerr << (mel ? "Mel" : "Linear") << " spectrogram must have shape [T, " << num_channels << "]" << std::endl;
+    return false;
+  }
+
+  (*num_frames) = size_t(spec.shape()[0]);
+
+  if (!mel) {
+    magnitude->resize(spec.size());
+    tts::spectrogram_to_amplitude(spec.data(), spec.size(), hparams.min_level_db,
+                                  hparams.ref_level_db, hparams.power, magnitude->data());
+    return true;
+  }
+
+  tts::MelConfig config;
+  config.sample_rate = hparams.sample_rate;
+  config.n_fft = size_t(hparams.num_freq - 1) * 2;
+  config.n_mels = size_t(hparams.num_mels);
+  std::shared_ptr<const tts::MelInverse> mel_inverse = tts::GetMelInverse(config);
+  if (!mel_inverse) {
+    return false;
+  }
+
+  // Same as keithito's `inv_mel_spectrogram`: the power is applied after
+  // mel to linear conversion.
+  std::vector<float> mel_amplitude(spec.size());
+  tts::spectrogram_to_amplitude(spec.data(), spec.size(), hparams.min_level_db,
+                                hparams.ref_level_db, 1.0f, mel_amplitude.data());
+
+  magnitude->resize((*num_frames) * mel_inverse->num_bins());
+  mel_inverse->apply(mel_amplitude.data(), *num_frames, magnitude->data());
+
+  tts::amplitude_power(magnitude->data(), magnitude->size(), hparams.power,
+                       magnitude->data());
+
+  return true;
+}
+
+// Reconstruct waveform from a normalized linear spectrogram with native
+// Griffin-Lim.
+bool VocodeGriffinLim(const tts::TensorView &spectrogram, const HyperParameters &hparams,
+                      bool mel, tts::GriffinLim &griffin_lim, std::vector<float> *wav)
+{
+  std::vector<float> magnitude;
+  size_t num_frames;
+  if (!GetMagnitude(spectrogram, hparams, mel, &magnitude, &num_frames)) {
+    return false;
+  }
+
+  auto startT = std::chrono::system_clock::now();
+
+  if (!griffin_lim.run(magnitude.data(), num_frames, wav)) {
+    return false;
+  }
+
+  auto endT = std::chrono::system_clock::now();
+  std::chrono::duration<double, std::milli> ms = endT - startT;
+  std::cout << "Griffin-Lim time : " << ms.count() << " [ms]" << std::endl;
+
+  return true;
+}
+
+// Reconstruct waveform frame by frame with streaming RTISI-LA. Finalized
+// audio is passed to `callback` as soon as it is available.
+bool VocodeRtisiLa(const tts::TensorView &spectrogram, const HyperParameters &hparams,
+                   bool mel, const tts::RtisiLa::Callback &callback)
+{
+  std::vector<float> magnitude;
+  size_t num_frames;
+  if (!GetMagnitude(spectrogram, hparams, mel, &magnitude, &num_frames)) {
+    return false;
+  }
+
+  const tts::GriffinLimConfig gl_config = GetGriffinLimConfig(hparams);
+  tts::RtisiLaConfig config;
+  config.n_fft = gl_config.n_fft;
+  config.hop_length = gl_config.hop_length;
+  config.win_length = gl_config.win_length;
+  config.lookahead = size_t(std::max(0, hparams.rtisi_lookahead));
+  config.iterations = hparams.rtisi_iters;
+
+  auto startT = std::chrono::system_clock::now();
+  double first_chunk_ms = -1.0;
+
+  tts::RtisiLa rtisi_la(config, [&](const float *samples, size_t n) {
+    if (first_chunk_ms < 0.0) {
+      first_chunk_ms = std::chrono::duration<double, std::milli>(std::chrono::system_clock::now() - startT).count();
+    }
+    callback(samples, n);
+  });
+
+  const size_t num_bins = size_t(hparams.num_freq);
+  for (size_t t = 0; t < num_frames; t++) {
+    if (!rtisi_la.push_frame(&magnitude[t * num_bins])) {
+      return false;
+    }
+  }
+  rtisi_la.finish();
+
+  auto endT = std::chrono::system_clock::now();
+  std::chrono::duration<double, std::milli> ms = endT - startT;
+  std::cout << "RTISI-LA time : " << ms.count() << " [ms] (first chunk : " << first_chunk_ms << " [ms])" << std::endl;
+
+  return true;
 }
 
-static uint16_t ftous(const float x)
+// Generate waveform from a mel spectrogram(shape = [T, num_mels] or
+// [1, T, num_mels]) with the WaveRNN vocoder.
+bool VocodeWaveRNN(const tts::TensorView &spectrogram, tts::WaveRNN &wavernn, std::vector<float> *wav)
 {
-  int f = int(x);
-  return std::max(uint16_t(0), std::min(std::numeric_limits<uint16_t>::max(), uint16_t(f)));
+  const tts::TensorView spec = (spectrogram.shape().size() == 3) ? spectrogram.slice(0) : spectrogram;
+  if ((spec.shape().size() != 2) || (spec.shape()[1] != wavernn.num_mels())) {
+    std::cerr << "Mel spectrogram must have shape [T, " << wavernn.num_mels() << "]" << std::endl;
+    return false;
+  }
+
+  return wavernn.synthesize(spec.data(), size_t(spec.shape()[0]), wav);
 }
 
-bool SaveWav(const std::string &filename, const std::vector<float> &samples, const int sample_rate)
+// Save fetched outputs(except for the first one = waveform) as JSON.
+// { "layer name" : { "shape" : [...], "data" : [...] }, ... }
+bool SaveFetches(const std::string &filename, const std::vector<std::string> &layers,
+                 const std::vector<tts::TensorView> &fetches)
 {
-  // We want to save audio with 32bit float format without loosing precision,
-  // but librosa only supports PCM audio, so save audio data as 16bit PCM.
+  nlohmann::json j = nlohmann::json::object();
+
+  for (size_t i = 1; i < fetches.size(); i++) {
+    nlohmann::json item;
+    item["shape"] = fetches[i].shape();
+    item["data"] = std::vector<float>(fetches[i].data(), fetches[i].data() + fetches[i].size());
+    j[layers[i]] = item;
+  }
+
+  std::ofstream os(filename);
+  if (!os) {
+    std::cerr << "Failed to open file for writing : " << filename << std::endl;
+    return false;
+  }
+
+  os << j;
+
+  return bool(os);
+}
+
+// Save peak normalized audio. `peak` is max(|samples|), which
+// post-processing already computed.
+// `output_format` is "pcm16", "float32", "mulaw" or "alaw". float32 audio is
+// normalized in place and written directly from `samples`.
+// `dither` is "none", "tpdf" or "shaped"(TPDF + noise shaping) for pcm16.
+bool SaveWav(const std::string &filename, std::vector<float> *samples, const int sample_rate,
+             const float peak, const std::string &output_format, const std::string &dither)
+{
+  if ((output_format == "mulaw") || (output_format == "alaw")) {
+    // dr_wav does not encode G.711.
+    tts::AudioWriterConfig config;
+    config.sample_rate = sample_rate;
+    config.format = (output_format == "mulaw") ? tts::kSampleFormatMuLaw : tts::kSampleFormatALaw;
+    tts::AudioWriter writer(config);
+    if (!writer.open(filename)) {
+      return false;
+    }
+    std::cout << "max value = " << peak << "\n";
+    const bool ret = writer.write(samples->data(), samples->size(), 1.0f / std::max(0.01f, peak));
+    return writer.close() && ret;
+  }
+
+  // 32bit float keeps full precision, but some tools(e.g. librosa) only
+  // support PCM audio, so 16bit PCM is the default.
+  const bool use_float = (output_format == "float32");
 
   drwav_data_format format;
   format.container = drwav_container_riff;     // <-- drwav_container_riff = normal WAV files, drwav_container_w64 = Sony Wave64.
-  format.format = DR_WAVE_FORMAT_PCM;
+  format.format = use_float ? DR_WAVE_FORMAT_IEEE_FLOAT : DR_WAVE_FORMAT_PCM;
   format.channels = 1;
-  format.sampleRate = sample_rate;
-  format.bitsPerSample = 16;
+  format.sampleRate = drwav_uint32(sample_rate);
+  format.bitsPerSample = use_float ? 32 : 16;
   drwav* pWav = drwav_open_file_write(filename.c_str(), &format);
+  if (!pWav) {
+    std::cerr << "Failed to open file for writing : " << filename << std::endl;
+    return false;
+  }
 
-  std::vector<unsigned short> data;
-  data.resize(samples.size());
+  std::cout << "max value = " << peak << "\n";
 
-  float max_value = std::fabs(samples[0]);
-  for (size_t i = 0; i < samples.size(); i++) {
-    max_value = std::max(max_value, std::fabs(samples[i]));
-  }
+  drwav_uint64 n = static_cast<drwav_uint64>(samples->size());
+  drwav_uint64 samples_written = 0;
 
-  std::cout << "max value = " << max_value << "\n";
+  if (use_float) {
+    // normalize to [-1, 1].
+    const float factor = 1.0f / std::max(0.01f, peak);
+    for (float &v : *samples) {
+      v *= factor;
+    }
+    samples_written = drwav_write(pWav, n, samples->data());
+  } else {
+    std::vector<int16_t> data(samples->size());
 
-  float factor = 32767.0f / std::max(0.01f, max_value);
+    float factor = 32767.0f / std::max(0.01f, peak);
 
-  // normalize & 16bit quantize.
-  for (size_t i = 0; i < samples.size(); i++) {
-    data[i] = ftous(factor * samples[i]);
-  }
+    // normalize & 16bit quantize.
+    if (dither == "none") {
+      tts::quantize_int16(samples->data(), samples->size(), factor, data.data());
+    } else {
+      tts::DitheredQuantizer quantizer(dither == "shaped");
+      quantizer.quantize(samples->data(), samples->size(), factor, data.data());
+    }
 
-  drwav_uint64 n = static_cast<drwav_uint64>(samples.size());
-  drwav_uint64 samples_written = drwav_write(pWav, n, data.data());
+    samples_written = drwav_write(pWav, n, data.data());
+  }
 
   drwav_close(pWav);
 
@@ -151,19 +549,53 @@ int main(int argc, char **argv) {
   options.add_options()("i,input", "Input sequence file(JSON)",
                         cxxopts::value<std::string>())(
       "g,graph", "Input freezed graph file", cxxopts::value<std::string>())
-      ("h,hparams", "Hyper parameters(JSON)", cxxopts::value<std::string>());
-      ("o,output", "Output WAV filename", cxxopts::value<std::string>());
+      ("h,hparams", "Hyper parameters(JSON)", cxxopts::value<std::string>())
+      ("o,output", "Output WAV filename(\"-\" = stdout, implies --stream)", cxxopts::value<std::string>())
+      ("stream", "Write audio of each sentence as soon as it is synthesized(e.g. to a FIFO). WAV header has the maximum length unless the output is seekable")
+      ("raw", "Write headerless raw samples instead of WAV(implies --stream)")
+      ("stream_peak", "Nominal peak amplitude of streamed audio, which is scaled by 1 / max(stream_peak, peak so far). Raw output is never amplified with the default 1.0", cxxopts::value<float>()->default_value("1.0"))
+      ("intra_op_threads", "The number of intra-op threads(0 = TensorFlow default)", cxxopts::value<int>())
+      ("inter_op_threads", "The number of inter-op threads(0 = TensorFlow default)", cxxopts::value<int>())
+      ("per_session_threads", "Use per-session inter-op thread pool instead of the global one")
+      ("cpu_affinity", "Pin the process to CPU cores(e.g. \"0,1,2,3\")", cxxopts::value<std::string>())
+      ("input_layer", "Name of input sequence layer", cxxopts::value<std::string>()->default_value("inputs"))
+      ("input_lengths_layer", "Name of input lengths layer", cxxopts::value<std::string>()->default_value("input_lengths"))
+      ("output_layer", "Name of output(waveform) layer", cxxopts::value<std::string>()->default_value("model/griffinlim/Squeeze"))
+      ("vocoder", "Vocoder. \"graph\"(Griffin-Lim in the graph), \"griffin_lim\"(native Griffin-Lim), \"rtisi_la\"(native streaming phase reconstruction) or \"wavernn\"(neural vocoder. requires --mel_layer and --wavernn_model)", cxxopts::value<std::string>()->default_value("graph"))
+      ("wavernn_model", "WaveRNN weight file(used by --vocoder wavernn)", cxxopts::value<std::string>())
+      ("vocoder_threads", "The number of native vocoder threads(0 = all cores, overrides hparams)", cxxopts::value<int>())
+      ("output_format", "Output sample format. \"pcm16\"(16bit PCM), \"float32\"(32bit float), \"mulaw\" or \"alaw\"(G.711. 8kHz unless --output_sample_rate is given)", cxxopts::value<std::string>()->default_value("pcm16"))
+      ("dither", "Dither for 16bit quantization(pcm16 only). \"none\", \"tpdf\" or \"shaped\"(TPDF with noise shaping)", cxxopts::value<std::string>()->default_value("none"))
+      ("output_sample_rate", "Sample rate of output WAV(e.g. 8000, 24000, 48000. 0 = model sample rate, overrides hparams)", cxxopts::value<int>())
+      ("griffin_lim_iters", "The number of native Griffin-Lim iterations(overrides hparams)", cxxopts::value<int>())
+      ("griffin_lim_momentum", "Momentum for fast Griffin-Lim(e.g. 0.99. 0 = classic Griffin-Lim)", cxxopts::value<float>())
+      ("linear_layer", "Name of linear spectrogram layer(used by native vocoder)", cxxopts::value<std::string>()->default_value("model/inference/dense/BiasAdd"))
+      ("mel_layer", "Name of mel spectrogram layer. Native vocoder reconstructs linear spectrogram from it instead of using linear_layer", cxxopts::value<std::string>())
+      ("fetch", "Additional output layer to fetch(e.g. spectrogram, alignments). Can be specified multiple times", cxxopts::value<std::vector<std::string>>())
+      ("dump_fetches", "Save additional fetched outputs to JSON file", cxxopts::value<std::string>())
+      ("memmapped", "Graph file is in memmapped format")
+      ("warmup", "Warm up the session with sequences of given lengths at load(e.g. \"16,64,128\")", cxxopts::value<std::string>())
+      ("convert_memmapped", "Convert the graph to memmapped format, save it to a given filename and exit", cxxopts::value<std::string>());
 
   auto result = options.parse(argc, argv);
 
-  if (!result.count("input")) {
-    std::cerr << "Please specify input sequence file with -i or --input option."
+  if (!result.count("graph")) {
+    std::cerr << "Please specify freezed graph with -g or --graph option."
               << std::endl;
     return EXIT_FAILURE;
   }
 
-  if (!result.count("graph")) {
-    std::cerr << "Please specify freezed graph with -g or --graph option."
+  if (result.count("convert_memmapped")) {
+    std::string memmapped_filename = result["convert_memmapped"].as<std::string>();
+    if (!tts::TensorflowSynthesizer::convert_to_memmapped(result["graph"].as<std::string>(), memmapped_filename)) {
+      return EXIT_FAILURE;
+    }
+    std::cout << "Saved memmapped graph : " << memmapped_filename << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  if (!result.count("input")) {
+    std::cerr << "Please specify input sequence file with -i or --input option."
               << std::endl;
     return EXIT_FAILURE;
   }
@@ -176,6 +608,78 @@ int main(int argc, char **argv) {
     }
   }
 
+  // Command line options override hyper parameter JSON.
+  if (result.count("intra_op_threads")) {
+    hparams.session.intra_op_threads = result["intra_op_threads"].as<int>();
+  }
+
+  if (result.count("inter_op_threads")) {
+    hparams.session.inter_op_threads = result["inter_op_threads"].as<int>();
+  }
+
+  if (result.count("per_session_threads")) {
+    hparams.session.use_per_session_threads = true;
+  }
+
+  if (result.count("cpu_affinity")) {
+    if (!ParseIntList(result["cpu_affinity"].as<std::string>(), &hparams.session.cpu_affinity)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (result.count("griffin_lim_iters")) {
+    hparams.griffin_lim_iters = result["griffin_lim_iters"].as<int>();
+  }
+
+  if (result.count("griffin_lim_momentum")) {
+    hparams.griffin_lim_momentum = result["griffin_lim_momentum"].as<float>();
+  }
+
+  if (result.count("vocoder_threads")) {
+    hparams.vocoder_threads = result["vocoder_threads"].as<int>();
+  }
+
+  if (result.count("output_sample_rate")) {
+    hparams.output_sample_rate = result["output_sample_rate"].as<int>();
+  }
+
+  hparams.session.input_lengths_layer = result["input_lengths_layer"].as<std::string>();
+
+  if (result.count("memmapped")) {
+    hparams.session.memmapped_graph = true;
+  }
+
+  if (result.count("warmup")) {
+    if (!ParseIntList(result["warmup"].as<std::string>(), &hparams.session.warmup_lengths)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  const std::string output_format = result["output_format"].as<std::string>();
+  if ((output_format != "pcm16") && (output_format != "float32") && (output_format != "mulaw") &&
+      (output_format != "alaw")) {
+    std::cerr << "Unknown output format : " << output_format << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // G.711 is telephony audio.
+  if (((output_format == "mulaw") || (output_format == "alaw")) && (hparams.output_sample_rate <= 0)) {
+    hparams.output_sample_rate = 8000;
+  }
+
+  const std::string dither = result["dither"].as<std::string>();
+  if ((dither != "none") && (dither != "tpdf") && (dither != "shaped")) {
+    std::cerr << "Unknown dither : " << dither << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Dither is +-1 LSB of 16bit PCM. G.711 steps are 16 to 1024 times coarser,
+  // so it would have no effect there, and float32 is not quantized.
+  if ((dither != "none") && (output_format != "pcm16")) {
+    std::cerr << "--dither is only supported for pcm16 output." << std::endl;
+    return EXIT_FAILURE;
+  }
+
   std::string input_filename = result["input"].as<std::string>();
   std::string graph_filename = result["graph"].as<std::string>();
   std::string output_filename = "output.wav";
@@ -184,58 +688,369 @@ int main(int argc, char **argv) {
     output_filename = result["output"].as<std::string>();
   }
 
-  std::vector<int32_t> sequence;
-  if (!LoadSequence(input_filename, &sequence)) {
+  const bool stream = (output_filename == "-") || result.count("stream") || result.count("raw");
+
+  const float nominal_stream_peak = result["stream_peak"].as<float>();
+  if (!(nominal_stream_peak > 0.0f)) {
+    std::cerr << "--stream_peak must be positive." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Audio goes to stdout, so print logs to stderr.
+  if (output_filename == "-") {
+    std::cout.rdbuf(std::cerr.rdbuf());
+  }
+
+  std::vector<std::vector<int32_t>> sequences;
+  if (!LoadSequences(input_filename, &sequences)) {
     std::cerr << "Failed to load sequence data : " << input_filename << std::endl;
     return EXIT_FAILURE;
   }
 
-  std::cout << "sequence = [";
-  for (size_t i = 0; i < sequence.size(); i++) {
-    std::cout << sequence[i];
-    if (i != (sequence.size() - 1)) {
-      std::cout << ", ";
+  for (const auto &sequence : sequences) {
+    std::cout << "sequence = [";
+    for (size_t i = 0; i < sequence.size(); i++) {
+      std::cout << sequence[i];
+      if (i != (sequence.size() - 1)) {
+        std::cout << ", ";
+      }
     }
+    std::cout << "]" << std::endl;
   }
-  std::cout << "]" << std::endl;
 
   // Synthesize(generate wav from sequence)
   tts::TensorflowSynthesizer tf_synthesizer;
   tf_synthesizer.init(argc, argv);
-  if (!tf_synthesizer.load(graph_filename, "inputs",
-                    "model/griffinlim/Squeeze")) {
+  const std::string vocoder = result["vocoder"].as<std::string>();
+  if ((vocoder != "graph") && (vocoder != "griffin_lim") && (vocoder != "rtisi_la") &&
+      (vocoder != "wavernn")) {
+    std::cerr << "Unknown vocoder : " << vocoder << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const bool use_mel = result.count("mel_layer") > 0;
+  if (use_mel && (vocoder == "graph")) {
+    std::cerr << "--mel_layer requires native vocoder(--vocoder griffin_lim, rtisi_la or wavernn)." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if ((vocoder == "wavernn") && (!use_mel || !result.count("wavernn_model"))) {
+    std::cerr << "--vocoder wavernn requires --mel_layer and --wavernn_model." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Model and vocoder stages run concurrently for multi-sentence input.
+  if ((sequences.size() > 1) && (vocoder != "graph")) {
+    SplitThreadBudget(vocoder, &hparams);
+  }
+
+  // Waveform(or linear/mel spectrogram for native vocoder) is always the
+  // first output. Additional layers(e.g. alignments) are fetched in the same
+  // session run.
+  std::vector<std::string> output_layers;
+  if (vocoder == "graph") {
+    output_layers.push_back(result["output_layer"].as<std::string>());
+  } else if (use_mel) {
+    output_layers.push_back(result["mel_layer"].as<std::string>());
+  } else {
+    output_layers.push_back(result["linear_layer"].as<std::string>());
+  }
+  if (result.count("fetch")) {
+    for (const auto &layer : result["fetch"].as<std::vector<std::string>>()) {
+      output_layers.push_back(layer);
+    }
+  }
+
+  if (!tf_synthesizer.load(graph_filename, result["input_layer"].as<std::string>(),
+                    output_layers, hparams.session)) {
     std::cerr << "Failed to load/setup Tensorflow model from a frozen graph : " << graph_filename << std::endl;
     return EXIT_FAILURE;
   }
 
+  // Load the neural vocoder once and share it among utterances.
+  tts::WaveRNN wavernn;
+  if (vocoder == "wavernn") {
+    if (!wavernn.load(result["wavernn_model"].as<std::string>())) {
+      return EXIT_FAILURE;
+    }
+
+    if (wavernn.sample_rate() != hparams.sample_rate) {
+      std::cerr << "WaveRNN sample rate(" << wavernn.sample_rate() << ") does not match hparams sample_rate("
+                << hparams.sample_rate << ")" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // Otherwise the output has wrong length and speed.
+    const int hop_length = int(hparams.frame_shift_ms / 1000.0f * float(hparams.sample_rate));
+    if (wavernn.hop_length() != hop_length) {
+      std::cerr << "WaveRNN hop length(" << wavernn.hop_length() << ") does not match hparams frame_shift_ms("
+                << hparams.frame_shift_ms << " ms = " << hop_length << " samples)" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Griffin-Lim keeps its thread pool and work buffers across utterances.
+  std::unique_ptr<tts::GriffinLim> griffin_lim;
+  if (vocoder == "griffin_lim") {
+    griffin_lim.reset(new tts::GriffinLim(GetGriffinLimConfig(hparams)));
+    if (!griffin_lim->valid()) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Graph and Griffin-Lim vocoders output pre-emphasized audio.
+  const bool preemphasized = (vocoder == "wavernn") ? wavernn.preemphasized() : true;
+
+  std::cout << "Ready." << std::endl;
+
   PrintHyperParameters(hparams);
 
   std::cout << "Synthesize..." << std::endl;
 
-  std::vector<int32_t> input_lengths;
-  input_lengths.push_back(int(sequence.size()));
+  // Per utterance state. Each stage only touches the utterance it is given,
+  // so no locking is required.
+  struct Utterance {
+    std::vector<tts::TensorView> fetches;
+    std::vector<float> wav;
+    size_t generated_length;
+    float peak;
+  };
+  std::vector<Utterance> utterances(sequences.size());
 
-  std::vector<float> wav0;
+  // Postprocess audio.
+  // 1. Inverse preemphasis
+  // 2. Remove silence
+  // Fused into one pass, which also finds the peak for normalization.
+  tts::PostProcessorConfig postprocess_config;
+  postprocess_config.sample_rate = hparams.sample_rate;
+  postprocess_config.preemphasis = preemphasized ? hparams.preemphasis : 0.0f;
+
+  // Inverse preemphasis of long audio(several seconds) is split across cores.
+  // Only for a single sentence: otherwise the stage overlaps the model and
+  // vocoder stages, which already use the cores.
+  std::unique_ptr<tts::ThreadPool> postprocess_pool;
+  if ((sequences.size() == 1) && preemphasized) {
+    postprocess_pool.reset(new tts::ThreadPool(hparams.session.cpu_affinity.size()));
+  }
+
+  const int output_sample_rate = (hparams.output_sample_rate > 0) ? hparams.output_sample_rate : hparams.sample_rate;
+  const bool convert_rate = (output_sample_rate != hparams.sample_rate);
+
+  // RTISI-LA emits audio every frame(after `rtisi_lookahead` frames), so
+  // streamed audio goes through post-processing, resampling and output chunk
+  // by chunk instead of sentence by sentence.
+  const bool stream_chunks = stream && (vocoder == "rtisi_la");
+
+  // Streaming output.
+  tts::AudioWriterConfig writer_config;
+  writer_config.sample_rate = output_sample_rate;
+  if (output_format == "float32") {
+    writer_config.format = tts::kSampleFormatFloat32;
+  } else if (output_format == "mulaw") {
+    writer_config.format = tts::kSampleFormatMuLaw;
+  } else if (output_format == "alaw") {
+    writer_config.format = tts::kSampleFormatALaw;
+  } else {
+    writer_config.format = tts::kSampleFormatPcm16;
+  }
+  writer_config.wav_header = !result.count("raw");
+  writer_config.dither = (dither != "none");
+  writer_config.noise_shaping = (dither == "shaped");
+  tts::AudioWriter writer(writer_config);
+
+  if (stream) {
+    if (!writer.open(output_filename)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The peak of the whole document is not known while streaming. Scale by the
+  // nominal peak, or by the peak so far once the audio exceeds it: the gain is
+  // fixed for normal audio(a quiet onset is not amplified), only decreases,
+  // and samples never clip.
+  float stream_peak = nominal_stream_peak;
+  bool write_failed = false;
+  auto write_stream = [&](const float *samples, size_t n) {
+    stream_peak = std::max(stream_peak, tts::peak_amplitude(samples, n));
+    if (!writer.write(samples, n, 1.0f / stream_peak)) {
+      write_failed = true;
+    }
+  };
 
-  if (!tf_synthesizer.synthesize(sequence, input_lengths, &wav0)) {
-    std::cerr << "Failed to synthesize for a given sequence." << std::endl;
+  // Sample rate conversion. Utterances go through one streaming resampler in
+  // order, so the filter runs across utterance boundaries as if the output
+  // was converted at once.
+  std::vector<float> resampled;
+  tts::Resampler resampler(hparams.sample_rate, output_sample_rate, [&](const float *samples, size_t n) {
+    if (stream_chunks) {
+      write_stream(samples, n);
+    } else {
+      resampled.insert(resampled.end(), samples, samples + n);
+    }
+  });
+  if (!resampler.valid()) {
     return EXIT_FAILURE;
   }
 
-  constexpr int32_t sample_rate = 20000;
+  // Chunk streaming: vocoder -> post-processor -> resampler -> writer.
+  tts::PostProcessor post_processor(postprocess_config, [&](const float *samples, size_t n) {
+    if (convert_rate) {
+      resampler.push(samples, n);
+    } else {
+      write_stream(samples, n);
+    }
+  });
 
-  // Postprocess audio.
-  // 1. Inverse preemphasis
-  // 2. Remove silence
-  std::vector<float> output_wav = tts::inv_preemphasis(wav0.data(), wav0.size(), -hparams.preemphasis);
-  size_t end_point = tts::find_end_point(output_wav.data(), output_wav.size(), sample_rate);
+  // Sentences of a document are processed in a pipeline: the model decodes
+  // sentence i + 1 while the vocoder processes sentence i.
+  tts::Pipeline pipeline;
+
+  pipeline.add_stage("model", [&](size_t i) {
+    std::vector<int32_t> input_lengths;
+    input_lengths.push_back(int(sequences[i].size()));
+    if (!tf_synthesizer.fetch(sequences[i], input_lengths, &utterances[i].fetches)) {
+      std::cerr << "Failed to synthesize for a given sequence." << std::endl;
+      return false;
+    }
+    return true;
+  });
+
+  if (vocoder != "graph") {
+    pipeline.add_stage("vocoder", [&](size_t i) {
+      Utterance &utterance = utterances[i];
+      bool ret = false;
+      if (vocoder == "griffin_lim") {
+        ret = VocodeGriffinLim(utterance.fetches[0], hparams, use_mel, *griffin_lim, &utterance.wav);
+      } else if (stream_chunks) {
+        ret = VocodeRtisiLa(utterance.fetches[0], hparams, use_mel, [&](const float *samples, size_t n) {
+          utterance.generated_length += n;
+          post_processor.push(samples, n);
+        });
+        post_processor.finish();
+        if (convert_rate && (i + 1 == utterances.size())) {
+          resampler.finish();
+        }
+      } else if (vocoder == "rtisi_la") {
+        std::vector<float> &wav = utterance.wav;
+        ret = VocodeRtisiLa(utterance.fetches[0], hparams, use_mel, [&](const float *samples, size_t n) {
+          wav.insert(wav.end(), samples, samples + n);
+        });
+      } else {
+        ret = VocodeWaveRNN(utterance.fetches[0], wavernn, &utterance.wav);
+      }
+      if (!ret) {
+        std::cerr << "Failed to reconstruct waveform from spectrogram." << std::endl;
+        return false;
+      }
+
+      if (stream_chunks) {
+        // Fetched outputs are only dumped for the first utterance.
+        if (i > 0) {
+          utterance.fetches.clear();
+        }
+        return !write_failed;
+      }
+      return true;
+    });
+  }
+
+  if (!stream_chunks) {
+    pipeline.add_stage("postprocess", [&](size_t i) {
+      Utterance &utterance = utterances[i];
+      std::vector<float> &wav = utterance.wav;
+      size_t end_point;
+      if (vocoder == "graph") {
+        // Filter directly out of the tensor.
+        const tts::TensorView &output = utterance.fetches[0];
+        wav.resize(output.size());
+        end_point = tts::postprocess_audio(output.data(), output.size(), postprocess_config, wav.data(),
+                                           &utterance.peak, postprocess_pool.get());
+      } else {
+        end_point = tts::postprocess_audio(wav.data(), wav.size(), postprocess_config, wav.data(),
+                                           &utterance.peak, postprocess_pool.get());
+      }
 
-  std::cout << "Generated wav has " << output_wav.size() << "samples \n";
-  std::cout << "Truncated to " << end_point << " samples(by removing silence duration)\n";
+      utterance.generated_length = wav.size();
+      wav.resize(end_point);
+
+      // Fetched outputs are only dumped for the first utterance.
+      if (i > 0) {
+        utterance.fetches.clear();
+      }
+      return true;
+    });
+
+    if (convert_rate) {
+      pipeline.add_stage("resample", [&](size_t i) {
+        Utterance &utterance = utterances[i];
+        resampled.clear();
+        resampler.push(utterance.wav.data(), utterance.wav.size());
+        if (i + 1 == utterances.size()) {
+          resampler.finish();
+        }
+        utterance.wav.swap(resampled);
+        // Interpolation can overshoot the peak of the input.
+        utterance.peak = tts::peak_amplitude(utterance.wav.data(), utterance.wav.size());
+        return true;
+      });
+    }
+
+    // Sentence streaming. Each sentence is written when it leaves the
+    // pipeline.
+    if (stream) {
+      pipeline.add_stage("output", [&](size_t i) {
+        Utterance &utterance = utterances[i];
+        write_stream(utterance.wav.data(), utterance.wav.size());
+        std::vector<float>().swap(utterance.wav);
+        return !write_failed;
+      });
+    }
+  }
+
+  if (!pipeline.run(sequences.size())) {
+    return EXIT_FAILURE;
+  }
+
+  if (sequences.size() > 1) {
+    pipeline.print_stats();
+  }
+
+  if (result.count("dump_fetches")) {
+    std::string dump_filename = result["dump_fetches"].as<std::string>();
+    if (!SaveFetches(dump_filename, output_layers, utterances[0].fetches)) {
+      std::cerr << "Failed to save fetched outputs : " << dump_filename << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (stream) {
+    size_t generated_length = 0;
+    for (const auto &utterance : utterances) {
+      generated_length += utterance.generated_length;
+    }
+    std::cout << "Generated wav has " << generated_length << "samples \n";
+    std::cout << "Wrote " << writer.num_samples() << " samples(by removing silence duration)\n";
+
+    if (!writer.close()) {
+      std::cerr << "Failed to write audio :" << output_filename << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+  }
+
+  std::vector<float> output_wav;
+  size_t generated_length = 0;
+  float peak = 0.0f;
+  for (const auto &utterance : utterances) {
+    output_wav.insert(output_wav.end(), utterance.wav.begin(), utterance.wav.end());
+    generated_length += utterance.generated_length;
+    peak = std::max(peak, utterance.peak);
+  }
 
-  output_wav.resize(end_point);
+  std::cout << "Generated wav has " << generated_length << "samples \n";
+  std::cout << "Truncated to " << output_wav.size() << " samples(by removing silence duration)\n";
 
-  if (!SaveWav(output_filename, output_wav, sample_rate)) {
+  if (!SaveWav(output_filename, &output_wav, output_sample_rate, peak, output_format, dither)) {
     std::cerr << "Failed to save wav file :" << output_filename << std::endl;
 
     return EXIT_FAILURE;
@@ -0,0 +1,272 @@
+#include "mel_inversion.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+
+#include "object_cache.h"
+
+namespace tts {
+
+namespace {
+
+// keithito's `_mel_to_linear` uses np.maximum(1e-10, ...).
+constexpr float kMinAmplitude = 1e-10f;
+
+// Eigenvalues below `kEigenTolerance * max eigenvalue` of M M^T are treated
+// as zero when computing the pseudo-inverse(singular values below 1e-6 of the
+// largest one, which is below float precision of the result).
+constexpr double kEigenTolerance = 1e-12;
+
+// GEMM block sizes: 4 frames x 256 bins of accumulators(4 KB) stay in L1
+// while rows of the inverse matrix are streamed.
+constexpr size_t kFrameBlock = 4;
+constexpr size_t kBinBlock = 256;
+
+// Slaney's mel scale(librosa.hz_to_mel(htk=False)).
+double HzToMel(double hz) {
+  const double f_sp = 200.0 / 3.0;
+  const double min_log_hz = 1000.0;
+  const double min_log_mel = min_log_hz / f_sp;
+  const double logstep = std::log(6.4) / 27.0;
+
+  if (hz >= min_log_hz) {
+    return min_log_mel + std::log(hz / min_log_hz) / logstep;
+  }
+  return hz / f_sp;
+}
+
+double MelToHz(double mel) {
+  const double f_sp = 200.0 / 3.0;
+  const double min_log_hz = 1000.0;
+  const double min_log_mel = min_log_hz / f_sp;
+  const double logstep = std::log(6.4) / 27.0;
+
+  if (mel >= min_log_mel) {
+    return min_log_hz * std::exp(logstep * (mel - min_log_mel));
+  }
+  return f_sp * mel;
+}
+
+//
+// Eigen decomposition of symmetric matrix `a`([n, n]) by cyclic Jacobi
+// rotations. On return, diagonal of `a` has eigenvalues and columns of `v`
+// are eigenvectors.
+//
+void JacobiEigen(size_t n, std::vector<double>* a, std::vector<double>* v) {
+  std::vector<double>& A = *a;
+  std::vector<double>& V = *v;
+
+  V.assign(n * n, 0.0);
+  for (size_t i = 0; i < n; i++) {
+    V[i * n + i] = 1.0;
+  }
+
+  for (int sweep = 0; sweep < 100; sweep++) {
+    double off = 0.0, diag = 0.0;
+    for (size_t i = 0; i < n; i++) {
+      diag += A[i * n + i] * A[i * n + i];
+      for (size_t j = i + 1; j < n; j++) {
+        off += A[i * n + j] * A[i * n + j];
+      }
+    }
+    if (off <= 1e-30 * diag) {
+      break;
+    }
+
+    for (size_t p = 0; p < n; p++) {
+      for (size_t q = p + 1; q < n; q++) {
+        const double apq = A[p * n + q];
+        if (std::fabs(apq) < 1e-300) {
+          continue;
+        }
+
+        const double theta = (A[q * n + q] - A[p * n + p]) / (2.0 * apq);
+        const double t = ((theta >= 0.0) ? 1.0 : -1.0) /
+                         (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+        const double c = 1.0 / std::sqrt(t * t + 1.0);
+        const double s = t * c;
+
+        for (size_t k = 0; k < n; k++) {
+          const double akp = A[k * n + p];
+          const double akq = A[k * n + q];
+          A[k * n + p] = c * akp - s * akq;
+          A[k * n + q] = s * akp + c * akq;
+        }
+        for (size_t k = 0; k < n; k++) {
+          const double apk = A[p * n + k];
+          const double aqk = A[q * n + k];
+          A[p * n + k] = c * apk - s * aqk;
+          A[q * n + k] = s * apk + c * aqk;
+        }
+        for (size_t k = 0; k < n; k++) {
+          const double vkp = V[k * n + p];
+          const double vkq = V[k * n + q];
+          V[k * n + p] = c * vkp - s * vkq;
+          V[k * n + q] = s * vkp + c * vkq;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+std::vector<float> MelFilterbank(const MelConfig& config) {
+  const size_t num_bins = config.n_fft / 2 + 1;
+  const size_t n_mels = config.n_mels;
+  const double sr = double(config.sample_rate);
+  const double fmax = (config.fmax > 0.0f) ? double(config.fmax) : sr / 2.0;
+
+  // Center frequencies of n_mels + 2 points evenly spaced in mel scale.
+  const double mel_min = HzToMel(double(config.fmin));
+  const double mel_max = HzToMel(fmax);
+  std::vector<double> mel_f(n_mels + 2);
+  for (size_t i = 0; i < n_mels + 2; i++) {
+    mel_f[i] = MelToHz(mel_min + (mel_max - mel_min) * double(i) /
+                                     double(n_mels + 1));
+  }
+
+  std::vector<float> weights(n_mels * num_bins, 0.0f);
+  for (size_t m = 0; m < n_mels; m++) {
+    const double lower_width = mel_f[m + 1] - mel_f[m];
+    const double upper_width = mel_f[m + 2] - mel_f[m + 1];
+    // Slaney-style area normalization.
+    const double enorm = 2.0 / (mel_f[m + 2] - mel_f[m]);
+
+    for (size_t k = 0; k < num_bins; k++) {
+      const double freq = sr * double(k) / double(config.n_fft);
+      const double lower = (freq - mel_f[m]) / lower_width;
+      const double upper = (mel_f[m + 2] - freq) / upper_width;
+      const double w = std::max(0.0, std::min(lower, upper));
+      weights[m * num_bins + k] = float(w * enorm);
+    }
+  }
+
+  return weights;
+}
+
+MelInverse::MelInverse(const MelConfig& config_) : config(config_) {
+  if ((config.sample_rate <= 0) || (config.n_fft < 2) ||
+      (config.n_mels == 0) ||
+      (config.fmax > 0.0f && config.fmax <= config.fmin)) {
+    std::cerr << "Invalid mel parameters : sample_rate " << config.sample_rate
+              << ", n_fft " << config.n_fft << ", n_mels " << config.n_mels
+              << ", fmin " << config.fmin << ", fmax " << config.fmax
+              << std::endl;
+    return;
+  }
+
+  const size_t n = config.n_mels;
+  const size_t bins = num_bins();
+  const std::vector<float> basis = MelFilterbank(config);
+
+  // pinv(M) = M^T pinv(M M^T). M M^T is only [n_mels, n_mels], so its
+  // pseudo-inverse is computed from the eigen decomposition.
+  std::vector<double> gram(n * n, 0.0);
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = i; j < n; j++) {
+      double sum = 0.0;
+      for (size_t k = 0; k < bins; k++) {
+        sum += double(basis[i * bins + k]) * double(basis[j * bins + k]);
+      }
+      gram[i * n + j] = gram[j * n + i] = sum;
+    }
+  }
+
+  std::vector<double> v;
+  JacobiEigen(n, &gram, &v);
+
+  double max_eigen = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    max_eigen = std::max(max_eigen, gram[i * n + i]);
+  }
+
+  std::vector<double> inv_eigen(n, 0.0);
+  for (size_t i = 0; i < n; i++) {
+    const double e = gram[i * n + i];
+    if (e > kEigenTolerance * max_eigen) {
+      inv_eigen[i] = 1.0 / e;
+    }
+  }
+
+  // G+ = V diag(1 / e) V^T
+  std::vector<double> gram_inv(n * n, 0.0);
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      double sum = 0.0;
+      for (size_t k = 0; k < n; k++) {
+        sum += v[i * n + k] * inv_eigen[k] * v[j * n + k];
+      }
+      gram_inv[i * n + j] = sum;
+    }
+  }
+
+  // inverse = pinv(M)^T = G+ M(G+ is symmetric).
+  inverse.assign(n * bins, 0.0f);
+  for (size_t i = 0; i < n; i++) {
+    for (size_t k = 0; k < bins; k++) {
+      double sum = 0.0;
+      for (size_t j = 0; j < n; j++) {
+        sum += gram_inv[i * n + j] * double(basis[j * bins + k]);
+      }
+      inverse[i * bins + k] = float(sum);
+    }
+  }
+}
+
+void MelInverse::apply(const float* mel, size_t num_frames,
+                       float* linear) const {
+  const size_t n = config.n_mels;
+  const size_t bins = num_bins();
+
+  float acc[kFrameBlock][kBinBlock];
+
+  for (size_t t0 = 0; t0 < num_frames; t0 += kFrameBlock) {
+    const size_t nt = std::min(kFrameBlock, num_frames - t0);
+
+    for (size_t k0 = 0; k0 < bins; k0 += kBinBlock) {
+      const size_t nk = std::min(kBinBlock, bins - k0);
+
+      for (size_t r = 0; r < nt; r++) {
+        std::fill(acc[r], acc[r] + nk, 0.0f);
+      }
+
+      for (size_t m = 0; m < n; m++) {
+        const float* row = &inverse[m * bins + k0];
+        for (size_t r = 0; r < nt; r++) {
+          const float a = mel[(t0 + r) * n + m];
+          float* dst = acc[r];
+          for (size_t k = 0; k < nk; k++) {
+            dst[k] += a * row[k];
+          }
+        }
+      }
+
+      for (size_t r = 0; r < nt; r++) {
+        float* dst = &linear[(t0 + r) * bins + k0];
+        for (size_t k = 0; k < nk; k++) {
+          dst[k] = std::max(kMinAmplitude, acc[r][k]);
+        }
+      }
+    }
+  }
+}
+
+std::shared_ptr<const MelInverse> GetMelInverse(const MelConfig& config) {
+  typedef std::tuple<int, size_t, size_t, float, float> Key;
+
+  static auto* cache = new ObjectCache<Key, MelInverse>();
+
+  const Key key(config.sample_rate, config.n_fft, config.n_mels, config.fmin,
+                config.fmax);
+
+  return cache->get(key, [&config]() -> std::shared_ptr<const MelInverse> {
+    std::shared_ptr<const MelInverse> mel_inverse =
+        std::make_shared<const MelInverse>(config);
+    return mel_inverse->valid() ? mel_inverse : nullptr;
+  });
+}
+
+}  // namespace tts
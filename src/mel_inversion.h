@@ -0,0 +1,73 @@
+#ifndef MEL_INVERSION_H_
+#define MEL_INVERSION_H_
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace tts {
+
+class MelConfig {
+ public:
+  // Defaults are keithito's tacotron hparams at 20kHz.
+  MelConfig()
+      : sample_rate(20000), n_fft(2048), n_mels(80), fmin(0.0f), fmax(0.0f) {}
+
+  int sample_rate;
+  size_t n_fft;
+  size_t n_mels;
+  float fmin;
+  // 0 = sample_rate / 2
+  float fmax;
+};
+
+///
+/// Mel filterbank. Same as librosa.filters.mel(htk=False, norm=1), which
+/// keithito's tacotron uses.
+///
+/// @return [n_mels, n_fft / 2 + 1]
+///
+std::vector<float> MelFilterbank(const MelConfig& config);
+
+///
+/// Mel to linear amplitude inversion with the pseudo-inverse of the mel
+/// filterbank(keithito's `_mel_to_linear`):
+///   linear = max(1e-10, pinv(M) mel)
+///
+/// The pseudo-inverse is computed once at construction and stored
+/// transposed([n_mels, num_bins]), so `apply()` streams contiguous rows
+/// across frames. Read-only after construction; use `GetMelInverse` to
+/// share one instance across threads and requests.
+///
+class MelInverse {
+ public:
+  explicit MelInverse(const MelConfig& config);
+
+  bool valid() const { return !inverse.empty(); }
+
+  size_t num_mels() const { return config.n_mels; }
+  size_t num_bins() const { return config.n_fft / 2 + 1; }
+
+  ///
+  /// @param[in] mel Mel amplitude. [num_frames, n_mels]
+  /// @param[in] num_frames The number of frames.
+  /// @param[out] linear Linear amplitude. [num_frames, n_fft / 2 + 1]
+  ///
+  void apply(const float* mel, size_t num_frames, float* linear) const;
+
+ private:
+  MelConfig config;
+
+  // Transposed pseudo-inverse. [n_mels, num_bins]
+  std::vector<float> inverse;
+};
+
+///
+/// Returns a cached `MelInverse` for (sample_rate, n_fft, n_mels, fmin,
+/// fmax). Returns nullptr when the configuration is invalid. Thread-safe.
+///
+std::shared_ptr<const MelInverse> GetMelInverse(const MelConfig& config);
+
+}  // namespace tts
+
+#endif  // MEL_INVERSION_H_
@@ -0,0 +1,49 @@
+#ifndef OBJECT_CACHE_H_
+#define OBJECT_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace tts {
+
+///
+/// Thread-safe cache of immutable objects(e.g. FFT plans, filters) shared
+/// by key. Objects live as long as the cache or any user holds them.
+///
+/// Intended to be allocated once and never freed, so that no destructor runs
+/// at exit while other threads may still use it:
+///
+///   static auto* cache = new ObjectCache<Key, Plan>();
+///
+template <typename Key, typename T>
+class ObjectCache {
+ public:
+  ///
+  /// Returns the cached object for `key`, or creates it with `create()`.
+  /// `create` is called with the cache locked, so each object is built once.
+  /// A nullptr returned by `create`(e.g. invalid parameters) is not cached.
+  ///
+  template <typename Create>
+  std::shared_ptr<const T> get(const Key& key, const Create& create) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+      return it->second;
+    }
+
+    std::shared_ptr<const T> object = create();
+    if (object) {
+      cache[key] = object;
+    }
+    return object;
+  }
+
+ private:
+  std::mutex mutex;
+  std::map<Key, std::shared_ptr<const T>> cache;
+};
+
+}  // namespace tts
+
+#endif  // OBJECT_CACHE_H_
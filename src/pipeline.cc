@@ -0,0 +1,149 @@
+#include "pipeline.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "spsc_queue.h"
+
+namespace tts {
+
+namespace {
+
+struct Token {
+  size_t index;
+  bool ok;
+  bool end;  // end of stream
+};
+
+//
+// Wait strategy for non-blocking queues: spin briefly(hand-off between
+// stages is usually immediate), then yield, then sleep. Stages take
+// milliseconds to seconds, so the sleep granularity is negligible.
+//
+class Backoff {
+ public:
+  Backoff() : count(0) {}
+
+  void wait() {
+    if (count < 64) {
+      count++;
+    } else if (count < 128) {
+      count++;
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  }
+
+ private:
+  int count;
+};
+
+}  // namespace
+
+Pipeline::Pipeline(size_t queue_capacity_)
+    : queue_capacity(queue_capacity_ > 0 ? queue_capacity_ : 1),
+      wall_ms(0.0) {}
+
+void Pipeline::add_stage(const std::string& name, const StageFn& fn) {
+  Stage stage;
+  stage.name = name;
+  stage.fn = fn;
+  stage.busy_ms = 0.0;
+  stages.push_back(stage);
+}
+
+bool Pipeline::run(size_t num_items) {
+  if (stages.empty()) {
+    return true;
+  }
+
+  auto startT = std::chrono::steady_clock::now();
+
+  // queues[k] connects stage k and stage k + 1.
+  std::vector<std::unique_ptr<SpscQueue<Token>>> queues;
+  for (size_t k = 0; k + 1 < stages.size(); k++) {
+    queues.emplace_back(new SpscQueue<Token>(queue_capacity));
+  }
+
+  std::atomic<bool> all_ok(true);
+
+  auto stage_loop = [&](size_t k) {
+    Stage& stage = stages[k];
+    stage.busy_ms = 0.0;
+    size_t next = 0;
+
+    for (;;) {
+      Token token;
+      if (k == 0) {
+        token.index = next++;
+        token.ok = true;
+        token.end = (token.index >= num_items);
+      } else {
+        Backoff backoff;
+        while (!queues[k - 1]->try_pop(&token)) {
+          backoff.wait();
+        }
+      }
+
+      if (!token.end && token.ok) {
+        auto s = std::chrono::steady_clock::now();
+        token.ok = stage.fn(token.index);
+        stage.busy_ms += std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - s)
+                             .count();
+        if (!token.ok) {
+          std::cerr << "Pipeline stage \"" << stage.name
+                    << "\" failed for item " << token.index << std::endl;
+          all_ok = false;
+        }
+      }
+
+      if (k + 1 < stages.size()) {
+        Backoff backoff;
+        Token t = token;
+        while (!queues[k]->try_push(std::move(t))) {
+          backoff.wait();
+        }
+      }
+
+      if (token.end) {
+        return;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t k = 1; k < stages.size(); k++) {
+    threads.emplace_back(stage_loop, k);
+  }
+  // The first stage runs on the calling thread(e.g. TensorFlow session
+  // which may have thread affinity set up).
+  stage_loop(0);
+
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  wall_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - startT)
+                .count();
+
+  return all_ok;
+}
+
+void Pipeline::print_stats() const {
+  double busy_sum = 0.0;
+  for (const auto& stage : stages) {
+    std::cout << "  stage " << stage.name << " : " << stage.busy_ms
+              << " [ms]" << std::endl;
+    busy_sum += stage.busy_ms;
+  }
+  std::cout << "  pipeline wall time : " << wall_ms
+            << " [ms](sequential : " << busy_sum << " [ms])" << std::endl;
+}
+
+}  // namespace tts
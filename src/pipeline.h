@@ -0,0 +1,64 @@
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tts {
+
+///
+/// Pipelined execution of per-item stages(e.g. model -> vocoder ->
+/// post-processing) over a sequence of items(e.g. sentences of a document).
+///
+/// Each stage runs on its own thread, so stage k of item i overlaps stage
+/// k - 1 of item i + 1. Stages are connected by bounded lock-free SPSC
+/// queues, and items leave every stage in submission order. Intra-stage
+/// parallelism(TensorFlow intra-op threads, Griffin-Lim threads) is the
+/// thread budget of each stage and is configured by the stage itself.
+///
+/// Stage functions receive the item index; the caller owns item storage.
+///
+class Pipeline {
+ public:
+  ///
+  /// @return false on failure. Later stages skip the item.
+  ///
+  typedef std::function<bool(size_t index)> StageFn;
+
+  ///
+  /// @param[in] queue_capacity The number of items which can wait between
+  /// two stages. Bounds memory usage when an early stage is faster.
+  ///
+  explicit Pipeline(size_t queue_capacity = 2);
+
+  void add_stage(const std::string& name, const StageFn& fn);
+
+  ///
+  /// Process items [0, num_items) through all stages. Blocks until done.
+  ///
+  /// @return false when any stage failed for any item.
+  ///
+  bool run(size_t num_items);
+
+  ///
+  /// Print busy time of each stage and total wall time of the last run.
+  ///
+  void print_stats() const;
+
+ private:
+  struct Stage {
+    std::string name;
+    StageFn fn;
+    double busy_ms;
+  };
+
+  size_t queue_capacity;
+  std::vector<Stage> stages;
+  double wall_ms;
+};
+
+}  // namespace tts
+
+#endif  // PIPELINE_H_
@@ -0,0 +1,131 @@
+#include "post_processor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "thread_pool.h"
+
+namespace tts {
+
+PostProcessor::PostProcessor(const PostProcessorConfig& config_,
+                             const Callback& callback_)
+    : config(config_),
+      callback(callback_),
+      detector(size_t(std::max(0, config_.sample_rate)),
+               config_.threshold_db, config_.min_silence_sec,
+               config_.absolute),
+      state(0.0f),
+      emitted(0) {}
+
+void PostProcessor::reset() {
+  detector.reset();
+  state = 0.0f;
+  emitted = 0;
+  pending.clear();
+}
+
+void PostProcessor::emit(size_t length) {
+  if (length <= emitted) {
+    return;
+  }
+  const size_t n = length - emitted;
+  callback(pending.data(), n);
+  pending.erase(pending.begin(), pending.begin() + std::ptrdiff_t(n));
+  emitted = length;
+}
+
+void PostProcessor::push(const float* wav, size_t len) {
+  if (ended() || (len == 0)) {
+    return;
+  }
+
+  const size_t offset = pending.size();
+  pending.resize(offset + len);
+  float* y = pending.data() + offset;
+  if (std::fabs(config.preemphasis) > 0.0f) {
+    state = inv_preemphasis(wav, len, -config.preemphasis, y, state);
+  } else {
+    std::copy(wav, wav + len, y);
+  }
+
+  if (!config.trim_silence) {
+    emit(emitted + pending.size());
+    return;
+  }
+
+  detector.push(y, len);
+  emit(detector.stable_length());
+
+  if (ended()) {
+    pending.clear();
+  }
+}
+
+void PostProcessor::finish() {
+  if (!ended()) {
+    emit(emitted + pending.size());
+  }
+  reset();
+}
+
+size_t postprocess_audio(const float* x, size_t len,
+                         const PostProcessorConfig& config, float* y,
+                         float* peak, ThreadPool* pool) {
+  // 16KB of float samples.
+  const size_t kBlockLength = 4096;
+
+  // Two chunks of the minimum parallel chunk of `inv_preemphasis_parallel`.
+  const size_t kMinParallelLength = 1 << 17;
+  const bool prefiltered = pool && (pool->num_threads() > 1) &&
+                           (std::fabs(config.preemphasis) > 0.0f) &&
+                           (len >= kMinParallelLength);
+  if (prefiltered) {
+    inv_preemphasis_parallel(x, len, -config.preemphasis, y, *pool);
+  }
+
+  EndPointDetector detector(size_t(std::max(0, config.sample_rate)),
+                            config.threshold_db, config.min_silence_sec,
+                            config.absolute);
+
+  // The end point is found up to one silence window after it, so keep the
+  // peak of each block to get the peak before the end point.
+  std::vector<float> block_peaks;
+  block_peaks.reserve(len / kBlockLength + 1);
+
+  float state = 0.0f;
+  size_t position = 0;
+  while (position < len) {
+    const size_t n = std::min(kBlockLength, len - position);
+    const float* src = x + position;
+    float* dst = y + position;
+    if (prefiltered) {
+      // Already filtered.
+    } else if (std::fabs(config.preemphasis) > 0.0f) {
+      state = inv_preemphasis(src, n, -config.preemphasis, dst, state);
+    } else if (src != dst) {
+      std::copy(src, src + n, dst);
+    }
+    block_peaks.push_back(peak_amplitude(dst, n));
+    position += n;
+
+    if (config.trim_silence && detector.push(dst, n)) {
+      break;
+    }
+  }
+
+  const size_t end_point = config.trim_silence ? detector.end_point() : len;
+
+  const size_t full_blocks = end_point / kBlockLength;
+  float m = 0.0f;
+  for (size_t b = 0; b < full_blocks; b++) {
+    m = std::max(m, block_peaks[b]);
+  }
+  m = std::max(m, peak_amplitude(y + full_blocks * kBlockLength,
+                                 end_point - full_blocks * kBlockLength));
+  (*peak) = m;
+
+  return end_point;
+}
+
+}  // namespace tts
@@ -0,0 +1,104 @@
+#ifndef POST_PROCESSOR_H_
+#define POST_PROCESSOR_H_
+
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "audio_util.h"
+
+namespace tts {
+
+class PostProcessorConfig {
+ public:
+  PostProcessorConfig()
+      : sample_rate(20000),
+        preemphasis(0.97f),
+        trim_silence(true),
+        threshold_db(-40.0f),
+        min_silence_sec(0.8f),
+        absolute(false) {}
+
+  int sample_rate;
+
+  // Same as hparams `preemphasis`. 0 = input is not pre-emphasized.
+  float preemphasis;
+
+  // Trailing silence removal(see `find_end_point`).
+  bool trim_silence;
+  float threshold_db;
+  float min_silence_sec;
+  bool absolute;
+};
+
+///
+/// Fused post-processing of a whole utterance: inverse preemphasis, end
+/// point detection and peak tracking in one pass over memory. Input is
+/// processed in blocks which fit in L1 cache, and each block is filtered,
+/// scanned for peak and fed to the silence detector while it is hot.
+/// Processing stops at the end point.
+///
+/// Same result as `inv_preemphasis` + `find_end_point` + peak of the
+/// truncated audio.
+///
+/// When `pool` is given and the audio is long(several seconds), inverse
+/// preemphasis of the whole input is done across threads first
+/// (`inv_preemphasis_parallel`), and the blocks are only scanned.
+///
+/// @param[out] y Filtered audio. Valid in [0, end point). `x` and `y` can be
+/// the same buffer.
+/// @param[out] peak max(|y[i]|) in [0, end point).
+/// @return End point.
+///
+size_t postprocess_audio(const float* x, size_t len,
+                         const PostProcessorConfig& config, float* y,
+                         float* peak, ThreadPool* pool = nullptr);
+
+///
+/// Streaming post-processing of synthesized audio: inverse preemphasis
+/// followed by removal of the trailing silence.
+///
+/// Audio is pushed in chunks of any size. The filter state and the silence
+/// detector state are carried across chunks, so the output is the same as
+/// `inv_preemphasis` + `find_end_point` on the whole utterance. Samples are
+/// emitted through the callback as soon as they can no longer be cut away,
+/// which is at most `min_silence_sec` behind the input.
+///
+class PostProcessor {
+ public:
+  typedef std::function<void(const float* samples, size_t num_samples)>
+      Callback;
+
+  PostProcessor(const PostProcessorConfig& config, const Callback& callback);
+
+  void push(const float* wav, size_t len);
+
+  ///
+  /// Emit the rest of the utterance. The object can be reused for a new
+  /// utterance after this call.
+  ///
+  void finish();
+
+  ///
+  /// @return true once the end point is found. Later input is discarded.
+  ///
+  bool ended() const { return detector.found(); }
+
+ private:
+  // Emit pending samples before `length`(index from the utterance start).
+  void emit(size_t length);
+
+  void reset();
+
+  PostProcessorConfig config;
+  Callback callback;
+  EndPointDetector detector;
+
+  float state;                 // inverse preemphasis filter state
+  size_t emitted;              // The number of samples emitted.
+  std::vector<float> pending;  // Filtered samples from `emitted` on.
+};
+
+}  // namespace tts
+
+#endif  // POST_PROCESSOR_H_
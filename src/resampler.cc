@@ -0,0 +1,256 @@
+#include "resampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "object_cache.h"
+
+namespace tts {
+
+namespace {
+
+const int kZeroCrossings = 16;
+const double kRolloff = 0.945;
+const double kKaiserBeta = 8.0;
+
+// Polyphase banks grow with L. Rate pairs with a larger reduced numerator
+// (e.g. 20000 -> 19999) are rejected.
+const size_t kMaxPhases = 1 << 14;
+
+// Modified Bessel function of the first kind, order 0(power series).
+double BesselI0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  const double q = 0.25 * x * x;
+  for (int k = 1; k < 64; k++) {
+    term *= q / double(k * k);
+    sum += term;
+    if (term < sum * 1e-17) {
+      break;
+    }
+  }
+  return sum;
+}
+
+size_t Gcd(size_t a, size_t b) {
+  while (b != 0) {
+    const size_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// n must be a multiple of 8.
+float Dot(const float* a, const float* b, size_t n) {
+#if defined(__AVX2__) && defined(__FMA__)
+  __m256 acc = _mm256_setzero_ps();
+  for (size_t i = 0; i < n; i += 8) {
+    acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+  }
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc),
+                        _mm256_extractf128_ps(acc, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+#elif defined(__SSE2__)
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  for (size_t i = 0; i < n; i += 8) {
+    acc0 = _mm_add_ps(acc0,
+                      _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc1 = _mm_add_ps(
+        acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  __m128 s = _mm_add_ps(acc0, acc1);
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  float32x4_t acc0 = vdupq_n_f32(0.0f);
+  float32x4_t acc1 = vdupq_n_f32(0.0f);
+  for (size_t i = 0; i < n; i += 8) {
+    acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+  }
+  return vaddvq_f32(vaddq_f32(acc0, acc1));
+#else
+  float sum = 0.0f;
+  for (size_t i = 0; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+#endif
+}
+
+}  // namespace
+
+ResamplerFilter::ResamplerFilter(int in_rate, int out_rate)
+    : input_rate(in_rate), output_rate(out_rate), L(0), M(0), K(0) {
+  if ((in_rate <= 0) || (out_rate <= 0)) {
+    std::cerr << "Invalid sample rate : " << in_rate << " -> " << out_rate
+              << std::endl;
+    return;
+  }
+
+  const size_t g = Gcd(size_t(in_rate), size_t(out_rate));
+  L = size_t(out_rate) / g;
+  M = size_t(in_rate) / g;
+  if (L > kMaxPhases) {
+    std::cerr << "Unsupported sample rate conversion : " << in_rate << " -> "
+              << out_rate << "(" << L << " phases)" << std::endl;
+    return;
+  }
+
+  // Cutoff relative to the input Nyquist frequency.
+  const double cutoff = kRolloff * std::min(1.0, double(L) / double(M));
+  const size_t half_taps = size_t(std::ceil(double(kZeroCrossings) / cutoff));
+  K = ((2 * half_taps + 7) / 8) * 8;
+  const double half_width = double(K / 2);
+
+  const double kPi = 3.14159265358979323846;
+  const double i0_beta = BesselI0(kKaiserBeta);
+
+  taps.resize(L * K);
+  std::vector<double> h(K);
+  for (size_t p = 0; p < L; p++) {
+    const double frac = double(p) / double(L);
+    double sum = 0.0;
+    for (size_t k = 0; k < K; k++) {
+      // Distance from the output position in input samples.
+      const double d = double(k) - (half_width - 1.0) - frac;
+      const double r = d / half_width;
+      double v = 0.0;
+      if (std::fabs(r) < 1.0) {
+        const double x = kPi * cutoff * d;
+        const double sinc = (std::fabs(x) < 1e-12) ? 1.0 : std::sin(x) / x;
+        v = cutoff * sinc * BesselI0(kKaiserBeta * std::sqrt(1.0 - r * r)) /
+            i0_beta;
+      }
+      h[k] = v;
+      sum += v;
+    }
+    for (size_t k = 0; k < K; k++) {
+      taps[p * K + k] = float(h[k] / sum);
+    }
+  }
+}
+
+std::shared_ptr<const ResamplerFilter> GetResamplerFilter(int in_rate,
+                                                          int out_rate) {
+  typedef std::pair<int, int> Key;
+
+  static auto* cache = new ObjectCache<Key, ResamplerFilter>();
+
+  const Key key(in_rate, out_rate);
+
+  return cache->get(key, [=]() -> std::shared_ptr<const ResamplerFilter> {
+    std::shared_ptr<const ResamplerFilter> filter =
+        std::make_shared<const ResamplerFilter>(in_rate, out_rate);
+    return filter->valid() ? filter : nullptr;
+  });
+}
+
+Resampler::Resampler(int in_rate, int out_rate, const Callback& callback_)
+    : filter(GetResamplerFilter(in_rate, out_rate)),
+      callback(callback_),
+      history_offset(0),
+      num_inputs(0),
+      num_outputs(0) {
+  reset();
+}
+
+void Resampler::reset() {
+  history_offset = 0;
+  num_inputs = 0;
+  num_outputs = 0;
+  history.clear();
+  if (filter) {
+    // Zero padding before the first sample.
+    history.resize(filter->num_taps() / 2 - 1, 0.0f);
+  }
+}
+
+void Resampler::produce(uint64_t limit) {
+  const uint64_t L = filter->up();
+  const uint64_t M = filter->down();
+  const size_t K = filter->num_taps();
+  const uint64_t available = history_offset + history.size();
+
+  output.clear();
+  for (; num_outputs < limit; num_outputs++) {
+    const uint64_t position = num_outputs * M;
+    const uint64_t i = position / L;
+    if (i + K > available) {
+      break;
+    }
+    output.push_back(Dot(filter->phase(size_t(position % L)),
+                         &history[size_t(i - history_offset)], K));
+  }
+
+  // Drop input which no later output uses.
+  const uint64_t next = std::min(num_outputs * M / L, available);
+  history.erase(history.begin(),
+                history.begin() + std::ptrdiff_t(next - history_offset));
+  history_offset = next;
+
+  if (!output.empty()) {
+    callback(output.data(), output.size());
+  }
+}
+
+void Resampler::push(const float* x, size_t len) {
+  if (!filter || (len == 0)) {
+    return;
+  }
+
+  if (filter->up() == filter->down()) {
+    callback(x, len);
+    return;
+  }
+
+  history.insert(history.end(), x, x + len);
+  num_inputs += len;
+  produce(UINT64_MAX);
+}
+
+void Resampler::finish() {
+  if (!filter) {
+    return;
+  }
+
+  if (filter->up() != filter->down()) {
+    // Zero padding after the last sample.
+    history.resize(history.size() + filter->num_taps() / 2, 0.0f);
+    const uint64_t L = filter->up();
+    const uint64_t M = filter->down();
+    produce((num_inputs * L + M - 1) / M);
+  }
+
+  reset();
+}
+
+bool resample(const float* x, size_t len, int in_rate, int out_rate,
+              std::vector<float>* y) {
+  y->clear();
+  Resampler resampler(in_rate, out_rate, [&](const float* samples, size_t n) {
+    y->insert(y->end(), samples, samples + n);
+  });
+  if (!resampler.valid()) {
+    return false;
+  }
+  resampler.push(x, len);
+  resampler.finish();
+  return true;
+}
+
+}  // namespace tts
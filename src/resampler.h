@@ -0,0 +1,112 @@
+#ifndef RESAMPLER_H_
+#define RESAMPLER_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace tts {
+
+///
+/// Polyphase filter bank for rational sample rate conversion
+/// out_rate / in_rate = L / M(reduced fraction).
+///
+/// Kaiser windowed sinc low-pass(16 zero crossings, beta = 8, cutoff at
+/// 94.5% of the lower Nyquist frequency) evaluated at the L fractional
+/// offsets. Each phase has `num_taps()` coefficients(multiple of 8 for
+/// SIMD, zero padded) normalized to unit DC gain.
+///
+/// Read-only after construction; use `GetResamplerFilter` to share one
+/// instance across threads and requests.
+///
+class ResamplerFilter {
+ public:
+  ResamplerFilter(int in_rate, int out_rate);
+
+  bool valid() const { return !taps.empty(); }
+
+  int in_rate() const { return input_rate; }
+  int out_rate() const { return output_rate; }
+
+  size_t up() const { return L; }
+  size_t down() const { return M; }
+  size_t num_taps() const { return K; }
+
+  ///
+  /// Coefficients of phase p(output at fractional input offset p / L).
+  /// Applied to input samples [i - K / 2 + 1, i + K / 2] where i is the
+  /// integer part of the output position.
+  ///
+  const float* phase(size_t p) const { return &taps[p * K]; }
+
+ private:
+  int input_rate;
+  int output_rate;
+  size_t L;
+  size_t M;
+  size_t K;
+  std::vector<float> taps;  // [L, K]
+};
+
+///
+/// Returns a cached `ResamplerFilter` for (in_rate, out_rate). Returns
+/// nullptr when the rates are invalid. Thread-safe.
+///
+std::shared_ptr<const ResamplerFilter> GetResamplerFilter(int in_rate,
+                                                          int out_rate);
+
+///
+/// Streaming sample rate converter. Input is pushed in chunks of any size
+/// and output is emitted through the callback as soon as enough input(half
+/// the filter length) is available. The output is the same as converting
+/// the whole signal at once.
+///
+class Resampler {
+ public:
+  typedef std::function<void(const float* samples, size_t num_samples)>
+      Callback;
+
+  Resampler(int in_rate, int out_rate, const Callback& callback);
+
+  bool valid() const { return filter != nullptr; }
+
+  void push(const float* x, size_t len);
+
+  ///
+  /// Flush the filter and emit the rest. Total output length is
+  /// ceil(input length * out_rate / in_rate). The object can be reused for a
+  /// new signal after this call.
+  ///
+  void finish();
+
+ private:
+  void reset();
+
+  // Compute outputs while input is available(and below `limit`).
+  void produce(uint64_t limit);
+
+  std::shared_ptr<const ResamplerFilter> filter;
+  Callback callback;
+
+  // Input history. Index 0 is `history_offset` of the zero padded input.
+  std::vector<float> history;
+  uint64_t history_offset;
+
+  uint64_t num_inputs;
+  uint64_t num_outputs;
+
+  std::vector<float> output;
+};
+
+///
+/// Convert the sample rate of a whole signal.
+/// @return false when the rates are invalid.
+///
+bool resample(const float* x, size_t len, int in_rate, int out_rate,
+              std::vector<float>* y);
+
+}  // namespace tts
+
+#endif  // RESAMPLER_H_
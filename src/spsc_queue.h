@@ -0,0 +1,68 @@
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+namespace tts {
+
+///
+/// Bounded lock-free single-producer single-consumer ring buffer.
+///
+/// `try_push` must only be called from one thread and `try_pop` from one
+/// (other) thread. Neither blocks; callers decide how to wait.
+///
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity)
+      : buffer(capacity + 1), head(0), tail(0) {}
+
+  size_t capacity() const { return buffer.size() - 1; }
+
+  ///
+  /// @return false when the queue is full(`value` is left untouched).
+  ///
+  bool try_push(T&& value) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    const size_t next = increment(t);
+    if (next == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    buffer[t] = std::move(value);
+    tail.store(next, std::memory_order_release);
+    return true;
+  }
+
+  ///
+  /// @return false when the queue is empty.
+  ///
+  bool try_pop(T* value) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    (*value) = std::move(buffer[h]);
+    head.store(increment(h), std::memory_order_release);
+    return true;
+  }
+
+ private:
+  size_t increment(size_t i) const {
+    return (i + 1 == buffer.size()) ? 0 : i + 1;
+  }
+
+  std::vector<T> buffer;
+
+  // Consumer and producer indices on separate cache lines. Padded instead
+  // of alignas, which needs C++17 aligned new for heap allocated queues.
+  std::atomic<size_t> head;
+  char padding[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> tail;
+};
+
+}  // namespace tts
+
+#endif  // SPSC_QUEUE_H_
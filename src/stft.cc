@@ -0,0 +1,181 @@
+#include "stft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+
+#include "object_cache.h"
+
+namespace tts {
+
+namespace {
+
+// Skip normalization where(almost) no window covers the sample, as
+// librosa.istft does.
+constexpr float kMinEnvelope = 1e-8f;
+
+// dst[i] = src[i] * w[i]
+void MultiplyWindow(const float* src, const float* w, float* dst, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    dst[i] = src[i] * w[i];
+  }
+}
+
+}  // namespace
+
+std::vector<float> MakeWindow(WindowType type, size_t length) {
+  const double kPi = 3.14159265358979323846;
+  std::vector<float> window(length, 1.0f);
+  if (type == kRectangularWindow) {
+    return window;
+  }
+
+  const double a0 = (type == kHammingWindow) ? 0.54 : 0.5;
+  for (size_t i = 0; i < length; i++) {
+    window[i] = float(
+        a0 - (1.0 - a0) * std::cos(2.0 * kPi * double(i) / double(length)));
+  }
+  return window;
+}
+
+StftWorkspace::StftWorkspace(const Stft& stft)
+    : buf(stft.get_config().n_fft), work(stft.get_config().n_fft) {}
+
+Stft::Stft(const StftConfig& config_) : config(config_) {
+  if ((config.hop_length == 0) || (config.win_length == 0) ||
+      (config.win_length > config.n_fft)) {
+    std::cerr << "Invalid STFT parameters : n_fft " << config.n_fft
+              << ", hop_length " << config.hop_length << ", win_length "
+              << config.win_length << std::endl;
+    return;
+  }
+
+  fft = GetRealFFT(config.n_fft);
+  if (!fft) {
+    std::cerr << "n_fft must be power of two : " << config.n_fft << std::endl;
+    return;
+  }
+
+  window = MakeWindow(config.window, config.win_length);
+
+  envelope_period.assign(config.hop_length, 0.0f);
+  for (size_t i = 0; i < config.win_length; i++) {
+    envelope_period[i % config.hop_length] += window[i] * window[i];
+  }
+}
+
+size_t Stft::num_frames(size_t length) const {
+  if (length < config.win_length) {
+    return 0;
+  }
+  return (length - config.win_length) / config.hop_length + 1;
+}
+
+size_t Stft::signal_length(size_t num_frames) const {
+  if (num_frames == 0) {
+    return 0;
+  }
+  return (num_frames - 1) * config.hop_length + config.win_length;
+}
+
+void Stft::forward(const float* frame, float* re, float* im,
+                   StftWorkspace* ws) const {
+  float* buf = ws->buf.data();
+  MultiplyWindow(frame, window.data(), buf, config.win_length);
+  std::fill(buf + config.win_length, buf + config.n_fft, 0.0f);
+
+  fft->forward(buf, re, im, ws->work.data());
+}
+
+void Stft::forward(const float* x, size_t num_frames, float* re, float* im,
+                   StftWorkspace* ws) const {
+  const size_t bins = num_bins();
+  for (size_t t = 0; t < num_frames; t++) {
+    forward(x + t * config.hop_length, re + t * bins, im + t * bins, ws);
+  }
+}
+
+void Stft::inverse(const float* re, const float* im, float* frame,
+                   StftWorkspace* ws) const {
+  float* buf = ws->buf.data();
+  fft->inverse(re, im, buf, ws->work.data());
+
+  // Inverse STFT only uses the first `win_length` samples of a frame.
+  MultiplyWindow(buf, window.data(), frame, config.win_length);
+}
+
+void Stft::inverse(const float* re, const float* im, size_t num_frames,
+                   float* frames, StftWorkspace* ws) const {
+  const size_t bins = num_bins();
+  for (size_t t = 0; t < num_frames; t++) {
+    inverse(re + t * bins, im + t * bins, frames + t * config.win_length, ws);
+  }
+}
+
+float Stft::envelope(size_t num_frames, size_t s) const {
+  const size_t hop = config.hop_length;
+  const size_t win_length = config.win_length;
+
+  // Every frame overlapping `s` exists, so the periodic envelope applies.
+  if ((s + hop >= win_length) && (s < num_frames * hop)) {
+    return envelope_period[s % hop];
+  }
+
+  // Edges.
+  float sum = 0.0f;
+  const size_t t_begin = (s >= win_length) ? (s - win_length) / hop + 1 : 0;
+  for (size_t t = t_begin; (t < num_frames) && (t * hop <= s); t++) {
+    const float w = window[s - t * hop];
+    sum += w * w;
+  }
+  return sum;
+}
+
+void Stft::overlap_add(const float* frames, size_t num_frames, size_t begin,
+                       size_t end, bool normalize, float* y) const {
+  const size_t hop = config.hop_length;
+  const size_t win_length = config.win_length;
+
+  std::fill(y + begin, y + end, 0.0f);
+
+  // First frame whose span [t * hop, t * hop + win_length) reaches `begin`.
+  const size_t t_begin =
+      (begin + 1 > win_length) ? (begin + 1 - win_length + hop - 1) / hop : 0;
+  const size_t t_end = std::min(num_frames, (end - 1) / hop + 1);
+
+  for (size_t t = t_begin; t < t_end; t++) {
+    const size_t offset = t * hop;
+    const size_t s0 = std::max(begin, offset);
+    const size_t s1 = std::min(end, offset + win_length);
+    const float* src = &frames[t * win_length + (s0 - offset)];
+    for (size_t i = s0; i < s1; i++) {
+      y[i] += *src++;
+    }
+  }
+
+  if (normalize) {
+    for (size_t i = begin; i < end; i++) {
+      const float e = envelope(num_frames, i);
+      if (e > kMinEnvelope) {
+        y[i] /= e;
+      }
+    }
+  }
+}
+
+std::shared_ptr<const Stft> GetStft(const StftConfig& config) {
+  typedef std::tuple<size_t, size_t, size_t, int> Key;
+
+  static auto* cache = new ObjectCache<Key, Stft>();
+
+  const Key key(config.n_fft, config.hop_length, config.win_length,
+                int(config.window));
+
+  return cache->get(key, [&config]() -> std::shared_ptr<const Stft> {
+    std::shared_ptr<const Stft> stft = std::make_shared<const Stft>(config);
+    return stft->valid() ? stft : nullptr;
+  });
+}
+
+}  // namespace tts
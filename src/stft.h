@@ -0,0 +1,163 @@
+#ifndef STFT_H_
+#define STFT_H_
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "fft.h"
+
+namespace tts {
+
+enum WindowType {
+  kHannWindow = 0,  // periodic Hann(tf.contrib.signal.hann_window)
+  kHammingWindow,   // periodic Hamming
+  kRectangularWindow,
+};
+
+///
+/// Periodic window of `length` samples.
+///
+std::vector<float> MakeWindow(WindowType type, size_t length);
+
+class StftConfig {
+ public:
+  StftConfig()
+      : n_fft(2048), hop_length(250), win_length(1000), window(kHannWindow) {}
+
+  StftConfig(size_t n_fft_, size_t hop_length_, size_t win_length_,
+             WindowType window_ = kHannWindow)
+      : n_fft(n_fft_),
+        hop_length(hop_length_),
+        win_length(win_length_),
+        window(window_) {}
+
+  // FFT length. Must be power of two.
+  size_t n_fft;
+  size_t hop_length;
+  // Window length(<= n_fft). Frames are zero padded to `n_fft`.
+  size_t win_length;
+  WindowType window;
+};
+
+class Stft;
+
+///
+/// Per thread scratch buffers for `Stft`. Allocate once and reuse, so
+/// transforms do not allocate.
+///
+class StftWorkspace {
+ public:
+  StftWorkspace() {}
+  explicit StftWorkspace(const Stft& stft);
+
+ private:
+  friend class Stft;
+
+  std::vector<float> buf;   // [n_fft]
+  std::vector<float> work;  // [n_fft]
+};
+
+///
+/// Non-centered STFT / inverse STFT(tf.contrib.signal.stft convention).
+///
+/// The FFT plan, the window and the overlap-add normalization envelope are
+/// computed once at construction and read-only afterwards, so one instance
+/// can be shared across threads and requests. Use `GetStft` to get a cached
+/// instance. All transforms write to caller buffers and do not allocate.
+///
+/// Spectra are stored in split format: `re` and `im` of `num_bins()`
+/// elements per frame.
+///
+class Stft {
+ public:
+  explicit Stft(const StftConfig& config);
+
+  ///
+  /// @return false when the configuration is invalid.
+  ///
+  bool valid() const { return fft != nullptr; }
+
+  const StftConfig& get_config() const { return config; }
+
+  size_t num_bins() const { return config.n_fft / 2 + 1; }
+
+  const std::vector<float>& get_window() const { return window; }
+
+  ///
+  /// The number of frames of a signal with `length` samples(0 if the signal
+  /// is shorter than the window).
+  ///
+  size_t num_frames(size_t length) const;
+
+  ///
+  /// The number of samples spanned by `num_frames` frames.
+  ///
+  size_t signal_length(size_t num_frames) const;
+
+  ///
+  /// Spectrum of one frame.
+  ///
+  /// @param[in] frame `win_length` samples(not windowed yet).
+  ///
+  void forward(const float* frame, float* re, float* im,
+               StftWorkspace* ws) const;
+
+  ///
+  /// Batched STFT of `num_frames` frames of signal `x`.
+  /// Frame t starts at `x + t * hop_length`.
+  ///
+  /// @param[out] re, im [num_frames, num_bins]
+  ///
+  void forward(const float* x, size_t num_frames, float* re, float* im,
+               StftWorkspace* ws) const;
+
+  ///
+  /// Windowed inverse FFT of one frame.
+  ///
+  /// @param[out] frame `win_length` samples.
+  ///
+  void inverse(const float* re, const float* im, float* frame,
+               StftWorkspace* ws) const;
+
+  ///
+  /// Batched version of above.
+  ///
+  /// @param[out] frames [num_frames, win_length]
+  ///
+  void inverse(const float* re, const float* im, size_t num_frames,
+               float* frames, StftWorkspace* ws) const;
+
+  ///
+  /// Overlap-add windowed frames([num_frames, win_length]) into samples
+  /// [begin, end) of `y`. Disjoint ranges can be computed in parallel.
+  ///
+  /// @param[in] normalize Divide by the sum of squared windows, so that
+  /// `inverse(forward(x))` reconstructs `x`. When false, frames are just
+  /// summed(tf.contrib.signal.inverse_stft).
+  ///
+  void overlap_add(const float* frames, size_t num_frames, size_t begin,
+                   size_t end, bool normalize, float* y) const;
+
+ private:
+  // Sum of squared windows of all frames overlapping sample `s`.
+  float envelope(size_t num_frames, size_t s) const;
+
+  StftConfig config;
+  std::shared_ptr<const RealFFT> fft;
+  std::vector<float> window;
+
+  // Steady state overlap-add envelope. [hop_length]
+  //   envelope_period[i] = sum_k window[i + k * hop]^2
+  std::vector<float> envelope_period;
+};
+
+///
+/// Returns a cached `Stft` for `config`. Returns nullptr when the
+/// configuration is invalid. Thread-safe.
+///
+std::shared_ptr<const Stft> GetStft(const StftConfig& config);
+
+}  // namespace tts
+
+#endif  // STFT_H_
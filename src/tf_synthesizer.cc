@@ -18,18 +18,30 @@
 #include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/io/path.h"
 #include "tensorflow/core/lib/strings/stringprintf.h"
+#include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/init_main.h"
 #include "tensorflow/core/platform/logging.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/public/session.h"
 #include "tensorflow/core/util/command_line_flags.h"
+#include "tensorflow/core/util/memmapped_file_system.h"
+
+#ifdef TTS_WITH_MEMMAPPED_CONVERTER
+#include "tensorflow/contrib/util/convert_graphdef_memmapped_format_lib.h"
+#endif
 
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
 
 #include <chrono>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 using namespace tensorflow;
 using namespace tensorflow::ops;
@@ -38,9 +50,55 @@ namespace tts {
 
 namespace {
 
+// Padding symbol id(`_`) in keithito's tacotron symbol set.
+constexpr int32_t kPadSymbol = 0;
+
+// EOS symbol id(`~`) in keithito's tacotron symbol set.
+constexpr int32_t kEOSSymbol = 1;
+
+// Symbol id range of 'a'-'z' in keithito's tacotron symbol set.
+constexpr int32_t kWarmupFirstSymbol = 28;
+constexpr int32_t kWarmupNumSymbols = 26;
+
+// Restricts the process(and threads created after this call) to the given
+// CPU cores.
+bool SetCPUAffinity(const std::vector<int>& cores) {
+#ifdef __linux__
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (int core : cores) {
+    if ((core < 0) || (core >= CPU_SETSIZE)) {
+      std::cerr << "Invalid CPU core id for affinity : " << core << std::endl;
+      return false;
+    }
+    CPU_SET(core, &cpuset);
+  }
+
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &cpuset) != 0) {
+    std::cerr << "sched_setaffinity failed." << std::endl;
+    return false;
+  }
+  return true;
+#else
+  (void)cores;
+  std::cerr << "CPU affinity is not supported on this platform. Ignored."
+            << std::endl;
+  return true;
+#endif
+}
+
+void SetupSessionOptions(const SynthesizerConfig& config,
+                         tensorflow::SessionOptions* options) {
+  ConfigProto& proto = options->config;
+  proto.set_intra_op_parallelism_threads(config.intra_op_threads);
+  proto.set_inter_op_parallelism_threads(config.inter_op_threads);
+  proto.set_use_per_session_threads(config.use_per_session_threads);
+}
+
 // Reads a model graph definition from disk, and creates a session object you
 // can use to run it.
 Status LoadGraph(const string& graph_file_name,
+                 const SynthesizerConfig& config,
                  std::unique_ptr<tensorflow::Session>* session) {
   tensorflow::GraphDef graph_def;
   Status load_graph_status =
@@ -49,61 +107,435 @@ Status LoadGraph(const string& graph_file_name,
     return tensorflow::errors::NotFound("Failed to load compute graph at '",
                                         graph_file_name, "'");
   }
-  session->reset(tensorflow::NewSession(tensorflow::SessionOptions()));
+
+  tensorflow::SessionOptions options;
+  SetupSessionOptions(config, &options);
+
+  session->reset(tensorflow::NewSession(options));
+  Status session_create_status = (*session)->Create(graph_def);
+  if (!session_create_status.ok()) {
+    return session_create_status;
+  }
+  return Status::OK();
+}
+
+// Loads a graph converted to memmapped format and creates a session object.
+// Constant tensors are not copied but `mmap`ed read-only from the file, so
+// `env` must outlive the session. `env` is only replaced when the session is
+// created, and `session` must not hold a session of the previous `env`.
+Status LoadMemmappedGraph(const string& graph_file_name,
+                          const SynthesizerConfig& config,
+                          std::unique_ptr<tensorflow::MemmappedEnv>* env,
+                          std::unique_ptr<tensorflow::Session>* session) {
+  std::unique_ptr<tensorflow::MemmappedEnv> new_env(
+      new tensorflow::MemmappedEnv(tensorflow::Env::Default()));
+  Status init_status = new_env->InitializeFromFile(graph_file_name);
+  if (!init_status.ok()) {
+    return tensorflow::errors::NotFound(
+        "Failed to load memmapped compute graph at '", graph_file_name,
+        "' : ", init_status.error_message());
+  }
+
+  tensorflow::GraphDef graph_def;
+  Status load_graph_status = ReadBinaryProto(
+      new_env.get(),
+      tensorflow::MemmappedFileSystem::kMemmappedPackageDefaultGraphDef,
+      &graph_def);
+  if (!load_graph_status.ok()) {
+    return load_graph_status;
+  }
+
+  tensorflow::SessionOptions options;
+  SetupSessionOptions(config, &options);
+  options.env = new_env.get();
+  // Constant folding would materialize the immutable tensors on the heap.
+  options.config.mutable_graph_options()
+      ->mutable_optimizer_options()
+      ->set_opt_level(::tensorflow::OptimizerOptions::L0);
+
+  session->reset(tensorflow::NewSession(options));
   Status session_create_status = (*session)->Create(graph_def);
   if (!session_create_status.ok()) {
+    // Destroy the session before `new_env` goes away.
+    session->reset();
     return session_create_status;
   }
+
+  *env = std::move(new_env);
   return Status::OK();
 }
 
+void PrintSessionConfig(const SynthesizerConfig& config) {
+  // TensorFlow uses the number of schedulable cores when 0 is specified.
+  const int num_cores = tensorflow::port::NumSchedulableCPUs();
+
+  std::cout << "Session configurations :\n";
+  std::cout << "  intra_op_threads : "
+            << ((config.intra_op_threads > 0) ? config.intra_op_threads
+                                              : num_cores)
+            << ((config.intra_op_threads > 0) ? "" : " (default)") << "\n";
+  std::cout << "  inter_op_threads : "
+            << ((config.inter_op_threads > 0) ? config.inter_op_threads
+                                              : num_cores)
+            << ((config.inter_op_threads > 0) ? "" : " (default)") << "\n";
+  std::cout << "  inter_op thread pool : "
+            << (config.use_per_session_threads ? "per session" : "global")
+            << "\n";
+  std::cout << "  schedulable cores : " << num_cores;
+  if (!config.cpu_affinity.empty()) {
+    std::cout << " (pinned to";
+    for (int core : config.cpu_affinity) {
+      std::cout << " " << core;
+    }
+    std::cout << ")";
+  }
+  std::cout << std::endl;
+}
+
 } // anonymous namespace
 
 class TensorflowSynthesizer::Impl {
 public:
+  ~Impl() {
+    if (session && has_callable) {
+      session->ReleaseCallable(callable);
+    }
+  }
+
   void init(int argc, char* argv[]) {
     // We need to call this to set up global state for TensorFlow.
     tensorflow::port::InitMain(argv[0], &argc, &argv);
   }
 
   bool load(const std::string& graph_filename, const std::string& inp_layer,
-            const std::string& out_layer) {
+            const std::vector<std::string>& out_layers, const SynthesizerConfig& config) {
+    if (out_layers.empty()) {
+      std::cerr << "No output layer is specified." << std::endl;
+      return false;
+    }
+
+    // Pin before creating the session so that TF's thread pools inherit it.
+    if (!config.cpu_affinity.empty()) {
+      if (!SetCPUAffinity(config.cpu_affinity)) {
+        return false;
+      }
+    }
+
+    // Reloading: release the callable and destroy the previous session
+    // before its memmapped env(if any) is replaced or a load fails.
+    ready = false;
+    if (session && has_callable) {
+      session->ReleaseCallable(callable);
+      has_callable = false;
+    }
+    session.reset();
+    memmapped_env.reset();
+
     // First we load and initialize the model.
-    Status load_graph_status = LoadGraph(graph_filename, &session);
+    Status load_graph_status =
+        config.memmapped_graph
+            ? LoadMemmappedGraph(graph_filename, config, &memmapped_env, &session)
+            : LoadGraph(graph_filename, config, &session);
     if (!load_graph_status.ok()) {
       std::cerr << load_graph_status;
       return false;
     }
 
     input_layer = inp_layer;
-    output_layer = out_layer;
+    input_lengths_layer = config.input_lengths_layer;
+    output_layers = out_layers;
+
+    // Resolve and validate feeds/fetches once, instead of on every run.
+    CallableOptions callable_options;
+    callable_options.add_feed(input_layer);
+    callable_options.add_feed(input_lengths_layer);
+    for (const auto& layer : output_layers) {
+      callable_options.add_fetch(layer);
+    }
+    Status callable_status = session->MakeCallable(callable_options, &callable);
+    if (!callable_status.ok()) {
+      std::cerr << "Failed to make callable: " << callable_status;
+      return false;
+    }
+    has_callable = true;
+
+    PrintSessionConfig(config);
+
+    if (!warmup(config.warmup_lengths)) {
+      return false;
+    }
+
+    ready = true;
+
+    return true;
+  }
+
+  bool is_ready() const { return ready; }
+
+  bool synthesize(const std::vector<int32_t>& input_sequence, const std::vector<int32_t>& input_lengths, TensorView *output) {
+    Tensor input_tensor, input_lengths_tensor;
+    if (!make_inputs(input_sequence, input_lengths, &input_tensor, &input_lengths_tensor)) {
+      return false;
+    }
+
+    std::vector<Tensor> output_tensors;
+    if (!run(input_tensor, input_lengths_tensor, &output_tensors)) {
+      return false;
+    }
+
+    return make_view(output_tensors[0], output_layers[0], output);
+  }
+
+  bool synthesize(const std::vector<std::vector<int32_t>>& sequences, std::vector<TensorView> *outputs) {
+    Tensor input_tensor, input_lengths_tensor;
+    if (!make_inputs(sequences, &input_tensor, &input_lengths_tensor)) {
+      return false;
+    }
+
+    std::vector<Tensor> output_tensors;
+    if (!run(input_tensor, input_lengths_tensor, &output_tensors)) {
+      return false;
+    }
+    const Tensor& output_tensor = output_tensors[0];
+
+    // `Squeeze` drops the batch dim when N = 1.
+    const int N = int(sequences.size());
+    if (output_tensor.dims() != ((N == 1) ? 1 : 2)) {
+      std::cerr << "Unexpected output shape " << output_tensor.shape().DebugString()
+                << " for batch size " << N << std::endl;
+      return false;
+    }
+
+    // Split [N, T_out] into per-utterance views sharing the output tensor.
+    // Each waveform has the length of the longest utterance in the batch.
+    // The padded tail is (near) silence and is removed by endpointing.
+    TensorView view;
+    if (!make_view(output_tensor, output_layers[0], &view)) {
+      return false;
+    }
+    outputs->resize(size_t(N));
+    for (int n = 0; n < N; n++) {
+      (*outputs)[size_t(n)] = (N == 1) ? view : view.slice(n);
+    }
 
     return true;
   }
 
+  bool fetch(const std::vector<int32_t>& input_sequence, const std::vector<int32_t>& input_lengths, std::vector<TensorView> *fetches) {
+    Tensor input_tensor, input_lengths_tensor;
+    if (!make_inputs(input_sequence, input_lengths, &input_tensor, &input_lengths_tensor)) {
+      return false;
+    }
+
+    return fetch(input_tensor, input_lengths_tensor, fetches);
+  }
+
+  bool fetch(const std::vector<std::vector<int32_t>>& sequences, std::vector<TensorView> *fetches) {
+    Tensor input_tensor, input_lengths_tensor;
+    if (!make_inputs(sequences, &input_tensor, &input_lengths_tensor)) {
+      return false;
+    }
+
+    return fetch(input_tensor, input_lengths_tensor, fetches);
+  }
+
   bool synthesize(const std::vector<int32_t>& input_sequence, const std::vector<int32_t>& input_lengths, std::vector<float> *output) {
+    TensorView view;
+    if (!synthesize(input_sequence, input_lengths, &view)) {
+      return false;
+    }
+
+    output->assign(view.data(), view.data() + view.size());
+    return true;
+  }
+
+  bool synthesize(const std::vector<std::vector<int32_t>>& sequences, std::vector<std::vector<float>> *outputs) {
+    std::vector<TensorView> views;
+    if (!synthesize(sequences, &views)) {
+      return false;
+    }
+
+    outputs->resize(views.size());
+    for (size_t n = 0; n < views.size(); n++) {
+      (*outputs)[n].assign(views[n].data(), views[n].data() + views[n].size());
+    }
+    return true;
+  }
+
+  bool synthesize(const std::vector<int32_t>& input_sequence, const std::vector<int32_t>& input_lengths, float *buffer, size_t buffer_size, size_t *output_size) {
+    TensorView view;
+    if (!synthesize(input_sequence, input_lengths, &view)) {
+      return false;
+    }
+
+    *output_size = view.size();
+    if (view.size() > buffer_size) {
+      std::cerr << "Output buffer is too small. Required " << view.size()
+                << " but got " << buffer_size << std::endl;
+      return false;
+    }
+
+    std::memcpy(buffer, view.data(), sizeof(float) * view.size());
+    return true;
+  }
+
+private:
+  // Float output only. Other dtypes fail(instead of CHECK-failing in
+  // `flat<float>()`).
+  static bool make_view(const Tensor& tensor, const std::string& layer, TensorView *view) {
+    if (tensor.dtype() != DT_FLOAT) {
+      std::cerr << "Output layer " << layer << " is not float : "
+                << DataTypeString(tensor.dtype()) << std::endl;
+      return false;
+    }
+
+    std::vector<int64_t> shape;
+    for (int d = 0; d < tensor.dims(); d++) {
+      shape.push_back(tensor.dim_size(d));
+    }
+
+    // Tensor copy shares(ref-counts) the underlying buffer, so the view keeps
+    // it alive without copying the data.
+    std::shared_ptr<const Tensor> holder = std::make_shared<const Tensor>(tensor);
+    *view = TensorView(holder, holder->flat<float>().data(), shape);
+    return true;
+  }
 
-    // Batch size = 1 for a while
-    int N = 1;
-    
+  // Input tensors for [N, T_in] flattened sequence.
+  static bool make_inputs(const std::vector<int32_t>& input_sequence, const std::vector<int32_t>& input_lengths,
+                          Tensor *input_tensor, Tensor *input_lengths_tensor) {
+    if (input_lengths.empty()) {
+      std::cerr << "input_lengths is empty." << std::endl;
+      return false;
+    }
 
-    int input_length = int(input_sequence.size()); 
-    Tensor input_tensor(DT_INT32, {N, input_length});
+    const int N = int(input_lengths.size());
+    if ((input_sequence.size() % size_t(N)) != 0) {
+      std::cerr << "input_sequence size " << input_sequence.size()
+                << " is not a multiple of batch size " << N << std::endl;
+      return false;
+    }
+    const int T_in = int(input_sequence.size() / size_t(N));
+
+    for (size_t i = 0; i < input_lengths.size(); i++) {
+      if ((input_lengths[i] <= 0) || (input_lengths[i] > T_in)) {
+        std::cerr << "Invalid input_lengths[" << i << "] = " << input_lengths[i]
+                  << " (T_in = " << T_in << ")" << std::endl;
+        return false;
+      }
+    }
 
+    *input_tensor = Tensor(DT_INT32, {N, T_in});
     std::copy_n(input_sequence.data(), input_sequence.size(),
-                input_tensor.flat<int32_t>().data());
+                input_tensor->flat<int32_t>().data());
+
+    *input_lengths_tensor = Tensor(DT_INT32, {N});
+    std::copy_n(input_lengths.data(), input_lengths.size(),
+                input_lengths_tensor->flat<int32_t>().data());
 
-    Tensor input_lengths_tensor(DT_INT32, {N});
+    return true;
+  }
+
+  // Input tensors for variable length sequences. Sequences are padded to the
+  // longest one.
+  static bool make_inputs(const std::vector<std::vector<int32_t>>& sequences,
+                          Tensor *input_tensor, Tensor *input_lengths_tensor) {
+    if (sequences.empty()) {
+      std::cerr << "No input sequences." << std::endl;
+      return false;
+    }
 
-    *(input_lengths_tensor.flat<int32_t>().data()) = input_length;
+    const int N = int(sequences.size());
+    int T_in = 0;
+    for (const auto& seq : sequences) {
+      if (seq.empty()) {
+        std::cerr << "Empty input sequence in a batch." << std::endl;
+        return false;
+      }
+      T_in = std::max(T_in, int(seq.size()));
+    }
 
-     auto startT = std::chrono::system_clock::now();
+    // Pad each sequence to T_in with the padding symbol(`_` = 0).
+    *input_tensor = Tensor(DT_INT32, {N, T_in});
+    *input_lengths_tensor = Tensor(DT_INT32, {N});
+    auto inputs = input_tensor->matrix<int32_t>();
+    auto lengths = input_lengths_tensor->vec<int32_t>();
+    for (int n = 0; n < N; n++) {
+      const std::vector<int32_t>& seq = sequences[size_t(n)];
+      std::copy_n(seq.data(), seq.size(), &inputs(n, 0));
+      std::fill_n(&inputs(n, 0) + seq.size(), size_t(T_in) - seq.size(), kPadSymbol);
+      lengths(n) = int32_t(seq.size());
+    }
 
+    return true;
+  }
 
-    // Run
+  bool fetch(const Tensor& input_tensor, const Tensor& input_lengths_tensor, std::vector<TensorView> *fetches) {
     std::vector<Tensor> output_tensors;
-    Status run_status = session->Run({{input_layer, input_tensor}, {"input_lengths", input_lengths_tensor}},
-                                     {output_layer}, {}, &output_tensors);
+    if (!run(input_tensor, input_lengths_tensor, &output_tensors)) {
+      return false;
+    }
+
+    fetches->assign(output_tensors.size(), TensorView());
+    for (size_t i = 0; i < output_tensors.size(); i++) {
+      if (!make_view(output_tensors[i], output_layers[i], &(*fetches)[i])) {
+        fetches->clear();
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // Runs synthetic sequences so that lazy kernel creation, allocator growth
+  // and thread pool spin-up happen here rather than in the first request.
+  // Each length is run twice to report cold and warm timings.
+  bool warmup(const std::vector<int>& lengths) {
+    for (int length : lengths) {
+      if (length <= 0) {
+        std::cerr << "Invalid warm-up length : " << length << std::endl;
+        return false;
+      }
+
+      // Cycle lowercase letters('a'-'z') and terminate with EOS('~').
+      std::vector<int32_t> sequence(size_t(length));
+      for (size_t i = 0; i < sequence.size(); i++) {
+        sequence[i] = kWarmupFirstSymbol + int32_t(i % kWarmupNumSymbols);
+      }
+      sequence.back() = kEOSSymbol;
+
+      Tensor input_tensor(DT_INT32, {1, length});
+      std::copy_n(sequence.data(), sequence.size(),
+                  input_tensor.flat<int32_t>().data());
+      Tensor input_lengths_tensor(DT_INT32, {1});
+      input_lengths_tensor.flat<int32_t>()(0) = length;
+
+      double ms[2];
+      for (int i = 0; i < 2; i++) {
+        auto startT = std::chrono::system_clock::now();
+        std::vector<Tensor> output_tensors;
+        if (!run(input_tensor, input_lengths_tensor, &output_tensors)) {
+          std::cerr << "Warm-up failed for length " << length << std::endl;
+          return false;
+        }
+        auto endT = std::chrono::system_clock::now();
+        ms[i] = std::chrono::duration<double, std::milli>(endT - startT).count();
+      }
+
+      std::cout << "Warm-up length " << length << " : cold " << ms[0]
+                << " [ms], warm " << ms[1] << " [ms]" << std::endl;
+    }
+
+    return true;
+  }
+
+  // Runs the model and fetches all output layers in one session run.
+  bool run(const Tensor& input_tensor, const Tensor& input_lengths_tensor, std::vector<Tensor> *output_tensors) {
+    auto startT = std::chrono::system_clock::now();
+
+    // Feed order must match `add_feed` order in `load()`.
+    const std::vector<Tensor> feeds = {input_tensor, input_lengths_tensor};
+    Status run_status = session->RunCallable(callable, feeds, output_tensors, nullptr);
     if (!run_status.ok()) {
       std::cerr << "Running model failed: " << run_status;
       return false;
@@ -112,27 +544,26 @@ public:
     auto endT = std::chrono::system_clock::now();
     std::chrono::duration<double, std::milli> ms = endT - startT;
 
-    std::cout << "Synth time : " << ms.count() << " [ms]" << std::endl;
-
-    const Tensor& output_tensor = output_tensors[0];
-    std::cout << "output dim " << output_tensor.dims() << std::endl;
+    std::cout << "Synth time : " << ms.count() << " [ms] (batch size "
+              << input_tensor.dim_size(0) << ")" << std::endl;
 
-    TTypes<float, 1>::ConstTensor tensor = output_tensor.tensor<float, 1>();
-    std::cout << "len = " << tensor.dimension(0) << std::endl;
-
-    assert(tensor.dimension(0) > 0);
-    output->resize(tensor.dimension(0));
-    // TODO(LTE): Use memcpy 
-    for (size_t i = 0; i < output->size(); i++) {
-      (*output)[i] = tensor(i);
+    for (size_t i = 0; i < output_tensors->size(); i++) {
+      std::cout << output_layers[i] << " shape "
+                << (*output_tensors)[i].shape().DebugString() << std::endl;
     }
 
-    return true;
+    return (output_tensors->size() == output_layers.size()) &&
+           ((*output_tensors)[0].NumElements() > 0);
   }
 
-private:
+  // Declared before `session` so that it is destroyed after the session.
+  std::unique_ptr<tensorflow::MemmappedEnv> memmapped_env;
   std::unique_ptr<tensorflow::Session> session;
-  std::string input_layer, output_layer;
+  std::string input_layer, input_lengths_layer;
+  std::vector<std::string> output_layers;
+  Session::CallableHandle callable = 0;
+  bool has_callable = false;
+  bool ready = false;
 };
 
 // PImpl pattern
@@ -143,14 +574,70 @@ void TensorflowSynthesizer::init(int argc, char* argv[]) {
 }
 bool TensorflowSynthesizer::load(const std::string& graph_filename,
                                const std::string& inp_layer,
-                               const std::string& out_layer) {
-  return impl->load(graph_filename, inp_layer, out_layer);
+                               const std::string& out_layer,
+                               const SynthesizerConfig& config) {
+  return impl->load(graph_filename, inp_layer, std::vector<std::string>{out_layer}, config);
+}
+
+bool TensorflowSynthesizer::load(const std::string& graph_filename,
+                               const std::string& inp_layer,
+                               const std::vector<std::string>& out_layers,
+                               const SynthesizerConfig& config) {
+  return impl->load(graph_filename, inp_layer, out_layers, config);
 }
 
+bool TensorflowSynthesizer::is_ready() const { return impl->is_ready(); }
+
 bool TensorflowSynthesizer::synthesize(const std::vector<int32_t> &input_sequence, const std::vector<int32_t> &input_lengths, std::vector<float> *output) {
   return impl->synthesize(input_sequence, input_lengths, output);
 }
 
+bool TensorflowSynthesizer::synthesize(const std::vector<std::vector<int32_t>> &sequences, std::vector<std::vector<float>> *outputs) {
+  return impl->synthesize(sequences, outputs);
+}
+
+bool TensorflowSynthesizer::synthesize(const std::vector<int32_t> &input_sequence, const std::vector<int32_t> &input_lengths, TensorView *output) {
+  return impl->synthesize(input_sequence, input_lengths, output);
+}
+
+bool TensorflowSynthesizer::synthesize(const std::vector<std::vector<int32_t>> &sequences, std::vector<TensorView> *outputs) {
+  return impl->synthesize(sequences, outputs);
+}
+
+bool TensorflowSynthesizer::fetch(const std::vector<int32_t> &input_sequence, const std::vector<int32_t> &input_lengths, std::vector<TensorView> *fetches) {
+  return impl->fetch(input_sequence, input_lengths, fetches);
+}
 
+bool TensorflowSynthesizer::fetch(const std::vector<std::vector<int32_t>> &sequences, std::vector<TensorView> *fetches) {
+  return impl->fetch(sequences, fetches);
+}
+
+bool TensorflowSynthesizer::synthesize(const std::vector<int32_t> &input_sequence, const std::vector<int32_t> &input_lengths, float *buffer, size_t buffer_size, size_t *output_size) {
+  return impl->synthesize(input_sequence, input_lengths, buffer, buffer_size, output_size);
+}
+
+
+bool TensorflowSynthesizer::convert_to_memmapped(
+    const std::string& graph_filename, const std::string& output_filename,
+    int min_conversion_tensor_size) {
+#ifdef TTS_WITH_MEMMAPPED_CONVERTER
+  Status status = tensorflow::ConvertConstantsToImmutable(
+      graph_filename, output_filename, min_conversion_tensor_size);
+  if (!status.ok()) {
+    std::cerr << "Failed to convert graph to memmapped format: " << status
+              << std::endl;
+    return false;
+  }
+  return true;
+#else
+  (void)graph_filename;
+  (void)output_filename;
+  (void)min_conversion_tensor_size;
+  std::cerr << "Memmapped graph conversion is not built in. Reconfigure with "
+               "-DTTS_WITH_MEMMAPPED_CONVERTER=On, or use TensorFlow's "
+               "`convert_graphdef_memmapped_format` tool." << std::endl;
+  return false;
+#endif
+}
 
 } // namespace tts
@@ -1,12 +1,94 @@
 #ifndef TF_SYNTHESIZER_H_
 #define TF_SYNTHESIZER_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace tts {
 
+class SynthesizerConfig {
+ public:
+  SynthesizerConfig()
+      : intra_op_threads(0),
+        inter_op_threads(0),
+        use_per_session_threads(false),
+        memmapped_graph(false),
+        input_lengths_layer("input_lengths") {}
+
+  // The number of threads used for parallelizing an op(e.g. MatMul).
+  // 0 = TensorFlow default(the number of cores).
+  int intra_op_threads;
+
+  // The number of threads for running independent ops concurrently.
+  // 0 = TensorFlow default(the number of cores).
+  int inter_op_threads;
+
+  // Use own inter-op thread pool for this session instead of the process
+  // global pool shared by all sessions.
+  bool use_per_session_threads;
+
+  // Pin the process to these CPU cores before creating the session, so
+  // TensorFlow's worker threads only run on them. Empty = no pinning.
+  // Linux only.
+  std::vector<int> cpu_affinity;
+
+  // Graph file is in TensorFlow's memmapped format(see
+  // `TensorflowSynthesizer::convert_to_memmapped`). Weights are `mmap`ed
+  // read-only instead of being copied to the heap, so processes loading the
+  // same file share them through the page cache.
+  bool memmapped_graph;
+
+  // Input lengths(T_in) of synthetic sequences run in `load()` to warm up
+  // the session. Empty = no warm-up.
+  std::vector<int> warmup_lengths;
+
+  // Name of the input lengths(shape = [N]) layer in the graph.
+  std::string input_lengths_layer;
+};
+
+///
+/// Read-only view of a float output tensor of the model.
+/// Any copy of the view keeps the underlying tensor buffer alive, so the data
+/// can be used without copying it out of the tensor.
+///
+class TensorView {
+ public:
+  TensorView() : ptr(nullptr), count(0) {}
+  TensorView(const std::shared_ptr<const void>& buffer_holder,
+             const float* data, const std::vector<int64_t>& shape)
+      : holder(buffer_holder), ptr(data), count(1), dims(shape) {
+    for (int64_t d : dims) {
+      count *= size_t(d);
+    }
+  }
+
+  const float* data() const { return ptr; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  const std::vector<int64_t>& shape() const { return dims; }
+
+  ///
+  /// View of i'th element along the first dimension(e.g. one utterance of a
+  /// batched output). Shares the buffer with this view.
+  ///
+  TensorView slice(int64_t i) const {
+    if (dims.empty() || (i < 0) || (i >= dims[0])) {
+      return TensorView();
+    }
+    const std::vector<int64_t> sub_dims(dims.begin() + 1, dims.end());
+    const size_t stride = count / size_t(dims[0]);
+    return TensorView(holder, ptr + size_t(i) * stride, sub_dims);
+  }
+
+ private:
+  std::shared_ptr<const void> holder;
+  const float* ptr;
+  size_t count;
+  std::vector<int64_t> dims;
+};
+
 class TensorflowSynthesizer {
  public:
   TensorflowSynthesizer();
@@ -16,9 +98,35 @@ class TensorflowSynthesizer {
 
   ///
   /// Load's pretrained TF model.
+  /// When `config.warmup_lengths` is given, returns after the session is
+  /// warmed up.
   ///
   bool load(const std::string& graph_filename, const std::string& inp_layer,
-            const std::string& out_layer);
+            const std::string& out_layer,
+            const SynthesizerConfig& config = SynthesizerConfig());
+
+  ///
+  /// Load's pretrained TF model with multiple output layers(e.g. waveform,
+  /// linear/mel spectrogram, alignments). All of them are fetched with a
+  /// single session run by `fetch()`. `synthesize()` returns the first one.
+  ///
+  bool load(const std::string& graph_filename, const std::string& inp_layer,
+            const std::vector<std::string>& out_layers,
+            const SynthesizerConfig& config = SynthesizerConfig());
+
+  ///
+  /// @return true when the model is loaded and warmed up.
+  ///
+  bool is_ready() const;
+
+  ///
+  /// Converts a frozen graph to memmapped format. Constant tensors larger than
+  /// `min_conversion_tensor_size` bytes are stored as immutable(mmap-able)
+  /// regions.
+  ///
+  static bool convert_to_memmapped(const std::string& graph_filename,
+                                   const std::string& output_filename,
+                                   int min_conversion_tensor_size = 10000);
 
   ///
   /// Synthesize speech.
@@ -27,10 +135,64 @@ class TensorflowSynthesizer {
   /// @param[in] input_lengths Tensor with shape = [N],  where N is batch size
   /// and values are the lengths
   ///      of each sequence in inputs.
-  /// @param[out] output Output audio data(floating point)
+  /// @param[out] output Output audio data(floating point). Shape = [N, T_out]
+  /// (flattened).
   ///
   bool synthesize(const std::vector<int32_t>& input_sequence, const std::vector<int32_t> &input_lengths, std::vector<float> *output);
 
+  ///
+  /// Synthesize speech for a batch of sequences with single session run.
+  /// Sequences are padded to the longest one in the batch.
+  ///
+  /// @param[in] sequences Input sequences. Each sequence can have different
+  /// length.
+  /// @param[out] outputs Output audio data(floating point) for each sequence.
+  /// All waveforms have the same length(T_out of the longest utterance), so
+  /// apply `find_end_point` to remove trailing silence.
+  ///
+  bool synthesize(const std::vector<std::vector<int32_t>>& sequences, std::vector<std::vector<float>> *outputs);
+
+  ///
+  /// Synthesize speech without copying the output out of the output tensor.
+  ///
+  /// @param[out] output View of output audio data. Shape = [N, T_out]
+  /// (N = 1 : [T_out]).
+  ///
+  bool synthesize(const std::vector<int32_t>& input_sequence, const std::vector<int32_t> &input_lengths, TensorView *output);
+
+  ///
+  /// Batched synthesis without copying the output.
+  ///
+  /// @param[out] outputs View of output audio data for each sequence. All
+  /// views share single output tensor.
+  ///
+  bool synthesize(const std::vector<std::vector<int32_t>>& sequences, std::vector<TensorView> *outputs);
+
+  ///
+  /// Run the model and fetch all output layers given to `load()`.
+  ///
+  /// @param[out] fetches Output tensors in the order of output layers. The
+  /// first dim is the batch dim, except for ops which squeeze it(e.g.
+  /// `model/griffinlim/Squeeze`) when N = 1.
+  ///
+  bool fetch(const std::vector<int32_t>& input_sequence, const std::vector<int32_t> &input_lengths, std::vector<TensorView> *fetches);
+
+  ///
+  /// Batched `fetch()`. Sequences are padded to the longest one. Use
+  /// `TensorView::slice()` to get outputs for each sequence.
+  ///
+  bool fetch(const std::vector<std::vector<int32_t>>& sequences, std::vector<TensorView> *fetches);
+
+  ///
+  /// Synthesize speech and write the output to a caller-provided buffer.
+  ///
+  /// @param[out] buffer Output audio data. Shape = [N, T_out] (flattened).
+  /// @param[in] buffer_size The number of floats `buffer` can hold.
+  /// @param[out] output_size The number of output floats. Set even when
+  /// `buffer_size` is too small(and false is returned).
+  ///
+  bool synthesize(const std::vector<int32_t>& input_sequence, const std::vector<int32_t> &input_lengths, float *buffer, size_t buffer_size, size_t *output_size);
+
  private:
   class Impl;
   std::unique_ptr<Impl> impl;
@@ -0,0 +1,101 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace tts {
+
+ThreadPool::ThreadPool(size_t num_threads)
+    : job(nullptr),
+      job_size(0),
+      job_chunks(0),
+      generation(0),
+      pending(0),
+      stopped(false) {
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (size_t i = 1; i < num_threads; i++) {
+    workers.emplace_back(&ThreadPool::worker, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+  }
+  start_cv.notify_all();
+
+  for (auto& w : workers) {
+    w.join();
+  }
+}
+
+void ThreadPool::run_chunk(size_t chunk) {
+  const size_t begin = (job_size * chunk) / job_chunks;
+  const size_t end = (job_size * (chunk + 1)) / job_chunks;
+  if (begin < end) {
+    (*job)(begin, end, chunk);
+  }
+}
+
+void ThreadPool::parallel_for(
+    size_t n, const std::function<void(size_t, size_t, size_t)>& fn) {
+  if (n == 0) {
+    return;
+  }
+
+  if (workers.empty() || (n == 1)) {
+    fn(0, n, 0);
+    return;
+  }
+
+  std::lock_guard<std::mutex> call_lock(call_mutex);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &fn;
+    job_size = n;
+    job_chunks = std::min(n, num_threads());
+    pending = job_chunks - 1;
+    generation++;
+  }
+  start_cv.notify_all();
+
+  run_chunk(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  done_cv.wait(lock, [this] { return pending == 0; });
+  job = nullptr;
+}
+
+void ThreadPool::worker(size_t index) {
+  size_t seen_generation = 0;
+
+  for (;;) {
+    std::unique_lock<std::mutex> lock(mutex);
+    start_cv.wait(lock, [this, seen_generation] {
+      return stopped || (generation != seen_generation);
+    });
+    if (stopped) {
+      return;
+    }
+    seen_generation = generation;
+
+    if (index >= job_chunks) {
+      // Fewer chunks than threads for this job.
+      continue;
+    }
+    lock.unlock();
+
+    run_chunk(index);
+
+    lock.lock();
+    if (--pending == 0) {
+      done_cv.notify_one();
+    }
+  }
+}
+
+}  // namespace tts
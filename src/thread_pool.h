@@ -0,0 +1,61 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tts {
+
+///
+/// Fixed size thread pool for data parallel loops.
+///
+class ThreadPool {
+ public:
+  ///
+  /// @param[in] num_threads The number of threads including the calling
+  /// thread. 0 = hardware concurrency.
+  ///
+  explicit ThreadPool(size_t num_threads = 0);
+  ~ThreadPool();
+
+  size_t num_threads() const { return workers.size() + 1; }
+
+  ///
+  /// Splits [0, n) into at most `num_threads()` contiguous chunks and runs
+  /// `fn(begin, end, chunk_index)` for each chunk in parallel. The calling
+  /// thread runs the first chunk. Blocks until all chunks finished.
+  /// `chunk_index` is in [0, num_threads()) and can be used to index
+  /// per-thread scratch buffers.
+  ///
+  /// Calls from multiple threads are serialized. Must not be called from
+  /// inside `fn`.
+  ///
+  void parallel_for(
+      size_t n, const std::function<void(size_t, size_t, size_t)>& fn);
+
+ private:
+  void worker(size_t index);
+  void run_chunk(size_t chunk);
+
+  std::vector<std::thread> workers;
+
+  std::mutex call_mutex;  // serializes `parallel_for`
+
+  std::mutex mutex;
+  std::condition_variable start_cv;
+  std::condition_variable done_cv;
+  const std::function<void(size_t, size_t, size_t)>* job;
+  size_t job_size;
+  size_t job_chunks;
+  size_t generation;
+  size_t pending;
+  bool stopped;
+};
+
+}  // namespace tts
+
+#endif  // THREAD_POOL_H_
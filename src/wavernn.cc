@@ -0,0 +1,588 @@
+#include "wavernn.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace tts {
+
+namespace {
+
+const char kMagic[8] = {'T', 'T', 'S', 'W', 'R', 'N', 'N', '1'};
+
+constexpr size_t kBlockRows = 8;
+constexpr size_t kBlockCols = 4;
+constexpr size_t kBlockSize = kBlockRows * kBlockCols;
+
+// Activations are quantized to [-127, 127] so that abs/sign tricks in the
+// SIMD kernels do not overflow.
+constexpr float kQuantMax = 127.0f;
+
+//
+// Block-sparse int8 matrix. See `wavernn.h` for the layout.
+//
+struct SparseMatrix {
+  SparseMatrix() : rows(0), cols(0) {}
+
+  size_t rows;
+  size_t cols;
+  std::vector<float> scale;           // [rows]
+  std::vector<uint32_t> row_offsets;  // [rows / 8 + 1], into block_cols
+  std::vector<uint32_t> block_cols;   // [num_blocks]
+  std::vector<int8_t> weights;        // [num_blocks * 32]
+};
+
+template <typename T>
+bool ReadValues(std::istream& is, T* dst, size_t count) {
+  is.read(reinterpret_cast<char*>(dst), std::streamsize(sizeof(T) * count));
+  return bool(is);
+}
+
+bool ReadFloats(std::istream& is, size_t count, std::vector<float>* dst) {
+  dst->resize(count);
+  return ReadValues(is, dst->data(), count);
+}
+
+bool ReadSparseMatrix(std::istream& is, size_t rows, size_t cols,
+                      SparseMatrix* m) {
+  uint32_t shape[2];
+  if (!ReadValues(is, shape, 2)) {
+    return false;
+  }
+  if ((shape[0] != rows) || (shape[1] != cols) || (rows % kBlockRows) ||
+      (cols % kBlockCols)) {
+    std::cerr << "Unexpected sparse matrix shape : [" << shape[0] << ", "
+              << shape[1] << "], expected [" << rows << ", " << cols << "]"
+              << std::endl;
+    return false;
+  }
+
+  m->rows = rows;
+  m->cols = cols;
+  if (!ReadFloats(is, rows, &m->scale)) {
+    return false;
+  }
+
+  m->row_offsets.assign(1, 0);
+  m->block_cols.clear();
+  m->weights.clear();
+
+  for (size_t r = 0; r < rows / kBlockRows; r++) {
+    uint32_t num_blocks;
+    if (!ReadValues(is, &num_blocks, 1) || (num_blocks > cols / kBlockCols)) {
+      return false;
+    }
+
+    const size_t offset = m->block_cols.size();
+    m->block_cols.resize(offset + num_blocks);
+    if (!ReadValues(is, &m->block_cols[offset], num_blocks)) {
+      return false;
+    }
+    for (size_t b = offset; b < m->block_cols.size(); b++) {
+      if (m->block_cols[b] >= cols / kBlockCols) {
+        std::cerr << "Block column out of range : " << m->block_cols[b]
+                  << std::endl;
+        return false;
+      }
+    }
+
+    m->weights.resize(m->block_cols.size() * kBlockSize);
+    if (!ReadValues(is, &m->weights[offset * kBlockSize],
+                    num_blocks * kBlockSize)) {
+      return false;
+    }
+
+    m->row_offsets.push_back(uint32_t(m->block_cols.size()));
+  }
+
+  // -128 would overflow in the sign trick of the SIMD kernels.
+  for (auto& w : m->weights) {
+    w = std::max(int8_t(-127), w);
+  }
+
+  return true;
+}
+
+//
+// Symmetric per-vector quantization: q = round(x / scale), scale = max|x| /
+// 127.
+// @return scale
+//
+float Quantize(const float* x, size_t n, int8_t* q) {
+  float max_abs = 0.0f;
+  for (size_t i = 0; i < n; i++) {
+    max_abs = std::max(max_abs, std::fabs(x[i]));
+  }
+  if (!(max_abs > 0.0f)) {
+    std::fill(q, q + n, int8_t(0));
+    return 0.0f;
+  }
+
+  // Round half away from zero. |x * inv_scale| <= 127.
+  const float inv_scale = kQuantMax / max_abs;
+  for (size_t i = 0; i < n; i++) {
+    const float v = x[i] * inv_scale;
+    q[i] = int8_t(int32_t(v + ((v < 0.0f) ? -0.5f : 0.5f)));
+  }
+  return max_abs / kQuantMax;
+}
+
+//
+// acc[0..7] = int8 dot products of a block row with quantized `x`.
+//
+void BlockRowDot(const SparseMatrix& m, size_t block_row, const int8_t* x,
+                 int32_t* acc) {
+  const uint32_t* cols = &m.block_cols[m.row_offsets[block_row]];
+  const size_t num_blocks =
+      m.row_offsets[block_row + 1] - m.row_offsets[block_row];
+  const int8_t* w = &m.weights[m.row_offsets[block_row] * kBlockSize];
+
+#if defined(__AVX2__)
+  // Each 32bit lane holds 4 weights of a row. maddubs(|x|, sign(w, x))
+  // multiplies pairs(no saturation since |x|, |w| <= 127) and madd with ones
+  // sums the pairs, giving one int32 per row.
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum = _mm256_setzero_si256();
+  for (size_t b = 0; b < num_blocks; b++) {
+    int32_t x4;
+    std::memcpy(&x4, x + cols[b] * kBlockCols, sizeof(int32_t));
+    const __m256i xv = _mm256_set1_epi32(x4);
+    const __m256i wv =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(w));
+    const __m256i p16 =
+        _mm256_maddubs_epi16(_mm256_abs_epi8(xv), _mm256_sign_epi8(wv, xv));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(p16, ones));
+    w += kBlockSize;
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(acc), sum);
+#elif defined(__SSSE3__)
+  const __m128i ones = _mm_set1_epi16(1);
+  __m128i sum0 = _mm_setzero_si128();
+  __m128i sum1 = _mm_setzero_si128();
+  for (size_t b = 0; b < num_blocks; b++) {
+    int32_t x4;
+    std::memcpy(&x4, x + cols[b] * kBlockCols, sizeof(int32_t));
+    const __m128i xv = _mm_set1_epi32(x4);
+    const __m128i xa = _mm_abs_epi8(xv);
+    const __m128i w0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w));
+    const __m128i w1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + 16));
+    const __m128i p0 = _mm_maddubs_epi16(xa, _mm_sign_epi8(w0, xv));
+    const __m128i p1 = _mm_maddubs_epi16(xa, _mm_sign_epi8(w1, xv));
+    sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(p0, ones));
+    sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(p1, ones));
+    w += kBlockSize;
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(acc), sum0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 4), sum1);
+#elif defined(__SSE2__)
+  // Sign extend to int16 and madd: lanes are pairwise sums of rows
+  // (0, 1), (2, 3), (4, 5), (6, 7), folded into one int32 per row after the
+  // loop.
+  __m128i s01 = _mm_setzero_si128();
+  __m128i s23 = _mm_setzero_si128();
+  __m128i s45 = _mm_setzero_si128();
+  __m128i s67 = _mm_setzero_si128();
+  for (size_t b = 0; b < num_blocks; b++) {
+    int32_t x4;
+    std::memcpy(&x4, x + cols[b] * kBlockCols, sizeof(int32_t));
+    const __m128i x8 = _mm_set1_epi32(x4);
+    const __m128i xv = _mm_srai_epi16(_mm_unpacklo_epi8(x8, x8), 8);
+    const __m128i w0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w));
+    const __m128i w1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(w + 16));
+    s01 = _mm_add_epi32(
+        s01, _mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(w0, w0), 8), xv));
+    s23 = _mm_add_epi32(
+        s23, _mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(w0, w0), 8), xv));
+    s45 = _mm_add_epi32(
+        s45, _mm_madd_epi16(_mm_srai_epi16(_mm_unpacklo_epi8(w1, w1), 8), xv));
+    s67 = _mm_add_epi32(
+        s67, _mm_madd_epi16(_mm_srai_epi16(_mm_unpackhi_epi8(w1, w1), 8), xv));
+    w += kBlockSize;
+  }
+  const __m128 a0 = _mm_castsi128_ps(s01);
+  const __m128 a1 = _mm_castsi128_ps(s23);
+  const __m128 a2 = _mm_castsi128_ps(s45);
+  const __m128 a3 = _mm_castsi128_ps(s67);
+  const __m128i sum0 = _mm_add_epi32(
+      _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(2, 0, 2, 0))),
+      _mm_castps_si128(_mm_shuffle_ps(a0, a1, _MM_SHUFFLE(3, 1, 3, 1))));
+  const __m128i sum1 = _mm_add_epi32(
+      _mm_castps_si128(_mm_shuffle_ps(a2, a3, _MM_SHUFFLE(2, 0, 2, 0))),
+      _mm_castps_si128(_mm_shuffle_ps(a2, a3, _MM_SHUFFLE(3, 1, 3, 1))));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(acc), sum0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + 4), sum1);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#if defined(__ARM_FEATURE_DOTPROD)
+  int32x4_t sum0 = vdupq_n_s32(0);
+  int32x4_t sum1 = vdupq_n_s32(0);
+  for (size_t b = 0; b < num_blocks; b++) {
+    int32_t x4;
+    std::memcpy(&x4, x + cols[b] * kBlockCols, sizeof(int32_t));
+    const int8x16_t xv = vreinterpretq_s8_s32(vdupq_n_s32(x4));
+    sum0 = vdotq_s32(sum0, vld1q_s8(w), xv);
+    sum1 = vdotq_s32(sum1, vld1q_s8(w + 16), xv);
+    w += kBlockSize;
+  }
+  vst1q_s32(acc, sum0);
+  vst1q_s32(acc + 4, sum1);
+#else
+  // Pairwise sums of rows(0, 1), (2, 3), (4, 5), (6, 7). Lanes are folded
+  // into one int32 per row after the loop.
+  int32x4_t s01 = vdupq_n_s32(0);
+  int32x4_t s23 = vdupq_n_s32(0);
+  int32x4_t s45 = vdupq_n_s32(0);
+  int32x4_t s67 = vdupq_n_s32(0);
+  for (size_t b = 0; b < num_blocks; b++) {
+    int32_t x4;
+    std::memcpy(&x4, x + cols[b] * kBlockCols, sizeof(int32_t));
+    const int8x8_t xv = vreinterpret_s8_s32(vdup_n_s32(x4));
+    const int8x16_t w0 = vld1q_s8(w);
+    const int8x16_t w1 = vld1q_s8(w + 16);
+    s01 = vpadalq_s16(s01, vmull_s8(vget_low_s8(w0), xv));
+    s23 = vpadalq_s16(s23, vmull_s8(vget_high_s8(w0), xv));
+    s45 = vpadalq_s16(s45, vmull_s8(vget_low_s8(w1), xv));
+    s67 = vpadalq_s16(s67, vmull_s8(vget_high_s8(w1), xv));
+    w += kBlockSize;
+  }
+  vst1q_s32(acc, vpaddq_s32(s01, s23));
+  vst1q_s32(acc + 4, vpaddq_s32(s45, s67));
+#endif
+#else
+  std::fill(acc, acc + kBlockRows, 0);
+  for (size_t b = 0; b < num_blocks; b++) {
+    const int8_t* xb = x + cols[b] * kBlockCols;
+    for (size_t r = 0; r < kBlockRows; r++) {
+      int32_t s = 0;
+      for (size_t c = 0; c < kBlockCols; c++) {
+        s += int32_t(w[r * kBlockCols + c]) * int32_t(xb[c]);
+      }
+      acc[r] += s;
+    }
+    w += kBlockSize;
+  }
+#endif
+}
+
+//
+// y = scale * (W q(x)) + bias
+//
+void SparseGemv(const SparseMatrix& m, const int8_t* x, float x_scale,
+                const float* bias, float* y) {
+  int32_t acc[kBlockRows];
+  for (size_t br = 0; br < m.rows / kBlockRows; br++) {
+    BlockRowDot(m, br, x, acc);
+    for (size_t r = 0; r < kBlockRows; r++) {
+      const size_t row = br * kBlockRows + r;
+      y[row] = bias[row] + m.scale[row] * x_scale * float(acc[r]);
+    }
+  }
+}
+
+//
+// y = W x + bias, W: [rows, cols] float.
+//
+void Gemv(const float* w, const float* x, const float* bias, size_t rows,
+          size_t cols, float* y) {
+  for (size_t r = 0; r < rows; r++) {
+    const float* wr = w + r * cols;
+    float sum = 0.0f;
+    for (size_t c = 0; c < cols; c++) {
+      sum += wr[c] * x[c];
+    }
+    y[r] = bias[r] + sum;
+  }
+}
+
+//
+// exp(x) with exp2 range reduction and a degree 5 polynomial(relative error
+// < 2e-6), accurate enough for activations and sampling. Written without
+// branches so that loops over it are vectorized.
+//
+inline float FastExp(float x) {
+  const float kLog2e = 1.4426950409f;
+  // clamp(x * log2(e), -126, 126) and floor(y + 0.5) are written with fabs
+  // and truncation of a positive value. std::min/max followed by float to int
+  // conversion keeps a branch(GCC does not if-convert it), and std::floor may
+  // be a library call without SSE4.1.
+  const float t = x * kLog2e;
+  const float y = 0.5f * (std::fabs(t + 126.0f) - std::fabs(t - 126.0f));
+  const int32_t m = int32_t(y + 126.5f);
+  const float f = y - (float(m) - 126.0f);
+  const float p =
+      1.0f +
+      f * (0.6931471806f +
+           f * (0.2402265070f +
+                f * (0.0555041087f + f * (0.0096181291f + f * 0.0013333558f))));
+  const uint32_t bits = uint32_t(m + 1) << 23;  // 2^(m - 126)
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(float));
+  return p * scale;
+}
+
+inline float FastSigmoid(float x) { return 1.0f / (1.0f + FastExp(-x)); }
+
+inline float FastTanh(float x) { return 2.0f * FastSigmoid(2.0f * x) - 1.0f; }
+
+}  // namespace
+
+class WaveRNN::Impl {
+ public:
+  Impl()
+      : ready(false),
+        sample_rate(0),
+        hop_length(0),
+        num_mels(0),
+        cond_dims(0),
+        rnn_dims(0),
+        fc_dims(0),
+        num_classes(0),
+        flags(0),
+        rng(0),
+        h_scale(0.0f) {}
+
+  bool load(const std::string& filename) {
+    ready = false;
+
+    std::ifstream is(filename, std::ios::binary);
+    if (!is) {
+      std::cerr << "Failed to open WaveRNN weights : " << filename
+                << std::endl;
+      return false;
+    }
+
+    char magic[8];
+    if (!ReadValues(is, magic, 8) || std::memcmp(magic, kMagic, 8) != 0) {
+      std::cerr << "Not a WaveRNN weight file : " << filename << std::endl;
+      return false;
+    }
+
+    uint32_t header[8];
+    if (!ReadValues(is, header, 8)) {
+      std::cerr << "Failed to read WaveRNN header." << std::endl;
+      return false;
+    }
+    sample_rate = header[0];
+    hop_length = header[1];
+    num_mels = header[2];
+    cond_dims = header[3];
+    rnn_dims = header[4];
+    fc_dims = header[5];
+    num_classes = header[6];
+    flags = header[7];
+
+    if ((sample_rate == 0) || (hop_length == 0) || (num_mels == 0) ||
+        (cond_dims == 0) || (rnn_dims % kBlockCols) ||
+        (fc_dims % kBlockRows) || (num_classes % kBlockRows) ||
+        (rnn_dims == 0) || (fc_dims == 0) || (num_classes < 2)) {
+      std::cerr << "Invalid WaveRNN dimensions : rnn_dims " << rnn_dims
+                << ", fc_dims " << fc_dims << ", num_classes "
+                << num_classes << std::endl;
+      return false;
+    }
+
+    const size_t gates = 3 * rnn_dims;
+    const bool ok =
+        ReadFloats(is, cond_dims * num_mels, &cond_w) &&
+        ReadFloats(is, cond_dims, &cond_b) &&
+        ReadFloats(is, gates * cond_dims, &gru_cond_w) &&
+        ReadFloats(is, gates, &gru_sample_w) &&
+        ReadFloats(is, gates, &gru_input_b) &&
+        ReadSparseMatrix(is, gates, rnn_dims, &gru_recurrent_w) &&
+        ReadFloats(is, gates, &gru_recurrent_b) &&
+        ReadSparseMatrix(is, fc_dims, rnn_dims, &fc1_w) &&
+        ReadFloats(is, fc_dims, &fc1_b) &&
+        ReadSparseMatrix(is, num_classes, fc_dims, &fc2_w) &&
+        ReadFloats(is, num_classes, &fc2_b);
+    if (!ok) {
+      std::cerr << "Failed to read WaveRNN weights(truncated or corrupted "
+                   "file) : "
+                << filename << std::endl;
+      return false;
+    }
+
+    // mu-law decoding table.
+    const double mu = double(num_classes - 1);
+    mu_law.resize(num_classes);
+    for (size_t c = 0; c < num_classes; c++) {
+      const double y = 2.0 * double(c) / mu - 1.0;
+      const double x = (std::pow(1.0 + mu, std::fabs(y)) - 1.0) / mu;
+      mu_law[c] = float((y < 0.0) ? -x : x);
+    }
+
+    cond.resize(cond_dims);
+    gi_cond.resize(gates);
+    gi.resize(gates);
+    gh.resize(gates);
+    h.resize(rnn_dims);
+    hq.resize(rnn_dims);
+    fc1.resize(fc_dims);
+    fc1q.resize(fc_dims);
+    logits.resize(num_classes);
+
+    size_t nnz = 0, total = 0;
+    for (const SparseMatrix* m : {&gru_recurrent_w, &fc1_w, &fc2_w}) {
+      nnz += m->weights.size();
+      total += m->rows * m->cols;
+    }
+    std::cout << "WaveRNN : rnn_dims " << rnn_dims << ", fc_dims " << fc_dims
+              << ", classes " << num_classes << ", density "
+              << double(nnz) / double(total) << std::endl;
+
+    ready = true;
+    return true;
+  }
+
+  bool synthesize(const float* mel, size_t num_frames,
+                  std::vector<float>* wav) {
+    if (!ready) {
+      std::cerr << "WaveRNN is not loaded." << std::endl;
+      return false;
+    }
+
+    auto startT = std::chrono::system_clock::now();
+
+    wav->resize(num_frames * hop_length);
+    std::fill(h.begin(), h.end(), 0.0f);
+    std::fill(hq.begin(), hq.end(), int8_t(0));
+    h_scale = 0.0f;
+    float prev = 0.0f;
+    size_t n = 0;
+
+    for (size_t t = 0; t < num_frames; t++) {
+      // Frame rate: conditioning and its contribution to GRU gates.
+      Gemv(cond_w.data(), mel + t * num_mels, cond_b.data(), cond_dims,
+           num_mels, cond.data());
+      for (auto& c : cond) {
+        c = FastTanh(c);
+      }
+      Gemv(gru_cond_w.data(), cond.data(), gru_input_b.data(), 3 * rnn_dims,
+           cond_dims, gi_cond.data());
+
+      for (size_t i = 0; i < hop_length; i++) {
+        prev = step(prev);
+        (*wav)[n++] = prev;
+      }
+    }
+
+    auto endT = std::chrono::system_clock::now();
+    std::chrono::duration<double, std::milli> ms = endT - startT;
+    const double audio_ms = 1000.0 * double(wav->size()) / double(sample_rate);
+    std::cout << "WaveRNN time : " << ms.count() << " [ms](real time factor "
+              << ms.count() / std::max(1.0, audio_ms) << ")" << std::endl;
+
+    return true;
+  }
+
+  bool ready;
+  size_t sample_rate, hop_length, num_mels, cond_dims, rnn_dims, fc_dims,
+      num_classes;
+  uint32_t flags;
+  std::mt19937 rng;
+
+ private:
+  // Generate one sample from the previous one.
+  float step(float prev) {
+    const size_t H = rnn_dims;
+
+    for (size_t k = 0; k < 3 * H; k++) {
+      gi[k] = gi_cond[k] + gru_sample_w[k] * prev;
+    }
+
+    // `hq` holds the quantized state of the previous step.
+    SparseGemv(gru_recurrent_w, hq.data(), h_scale, gru_recurrent_b.data(),
+               gh.data());
+
+    for (size_t k = 0; k < H; k++) {
+      const float z = FastSigmoid(gi[k] + gh[k]);
+      const float r = FastSigmoid(gi[H + k] + gh[H + k]);
+      const float c = FastTanh(gi[2 * H + k] + r * gh[2 * H + k]);
+      h[k] = z * h[k] + (1.0f - z) * c;
+    }
+    h_scale = Quantize(h.data(), H, hq.data());
+
+    SparseGemv(fc1_w, hq.data(), h_scale, fc1_b.data(), fc1.data());
+    for (auto& v : fc1) {
+      v = std::max(0.0f, v);
+    }
+    const float fc1_scale = Quantize(fc1.data(), fc_dims, fc1q.data());
+
+    SparseGemv(fc2_w, fc1q.data(), fc1_scale, fc2_b.data(), logits.data());
+
+    return mu_law[sample_class()];
+  }
+
+  // Draw a class from softmax(logits).
+  size_t sample_class() {
+    const float max_logit = *std::max_element(logits.begin(), logits.end());
+    float sum = 0.0f;
+    for (auto& l : logits) {
+      l = FastExp(l - max_logit);
+      sum += l;
+    }
+
+    const float u = std::uniform_real_distribution<float>(0.0f, sum)(rng);
+    float cdf = 0.0f;
+    for (size_t c = 0; c < num_classes; c++) {
+      cdf += logits[c];
+      if (u < cdf) {
+        return c;
+      }
+    }
+    return num_classes - 1;
+  }
+
+  std::vector<float> cond_w, cond_b;
+  std::vector<float> gru_cond_w, gru_sample_w, gru_input_b;
+  SparseMatrix gru_recurrent_w;
+  std::vector<float> gru_recurrent_b;
+  SparseMatrix fc1_w;
+  std::vector<float> fc1_b;
+  SparseMatrix fc2_w;
+  std::vector<float> fc2_b;
+
+  std::vector<float> mu_law;  // class -> sample
+
+  // Work buffers. Allocated at load.
+  std::vector<float> cond, gi_cond, gi, gh, h, fc1, logits;
+  std::vector<int8_t> hq, fc1q;
+  float h_scale;
+};
+
+WaveRNN::WaveRNN() : impl(new Impl()) {}
+
+WaveRNN::~WaveRNN() {}
+
+bool WaveRNN::load(const std::string& filename) {
+  return impl->load(filename);
+}
+
+bool WaveRNN::is_ready() const { return impl->ready; }
+
+int WaveRNN::sample_rate() const { return int(impl->sample_rate); }
+
+int WaveRNN::hop_length() const { return int(impl->hop_length); }
+
+int WaveRNN::num_mels() const { return int(impl->num_mels); }
+
+bool WaveRNN::preemphasized() const { return (impl->flags & 1) != 0; }
+
+void WaveRNN::set_seed(uint32_t seed) { impl->rng.seed(seed); }
+
+bool WaveRNN::synthesize(const float* mel, size_t num_frames,
+                         std::vector<float>* wav) {
+  return impl->synthesize(mel, num_frames, wav);
+}
+
+}  // namespace tts
@@ -0,0 +1,96 @@
+#ifndef WAVERNN_H_
+#define WAVERNN_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tts {
+
+///
+/// Lightweight CPU neural vocoder(WaveRNN-class) conditioned on mel
+/// spectrogram.
+///
+/// Network, per output sample t:
+///   cond   = tanh(W_c mel[frame(t)] + b_c)            (once per frame)
+///   x      = [s(t-1), cond]
+///   h      = GRU(x, h)     (reset-after formulation, like Keras/LPCNet)
+///   o      = relu(W_1 h + b_1)
+///   p      = softmax(W_2 o + b_2)                      (mu-law classes)
+///   s(t)   = mu_law_decode(sample from p)
+///
+/// The input part of the GRU for the conditioning vector is computed once
+/// per frame, so the per-sample work is the recurrent matrix and two dense
+/// layers. Those are block-sparse int8 matrices(8 x 4 blocks, per-row float
+/// scale) multiplied with int8 quantized activations using AVX2, SSSE3 or
+/// NEON integer dot products.
+///
+/// Weight file format(little endian):
+///
+///   char[8]  magic "TTSWRNN1"
+///   uint32   sample_rate, hop_length, num_mels, cond_dims, rnn_dims,
+///            fc_dims, num_classes, flags(bit 0: output is pre-emphasized)
+///   float    W_c[cond_dims][num_mels], b_c[cond_dims]
+///   float    W_ic[3 * rnn_dims][cond_dims]    GRU input weights(cond)
+///   float    w_is[3 * rnn_dims]               GRU input weights(sample)
+///   float    b_i[3 * rnn_dims]
+///   sparse   W_h(3 * rnn_dims, rnn_dims)      GRU recurrent weights
+///   float    b_h[3 * rnn_dims]
+///   sparse   W_1(fc_dims, rnn_dims),    float b_1[fc_dims]
+///   sparse   W_2(num_classes, fc_dims), float b_2[num_classes]
+///
+/// GRU gates are ordered (update, reset, candidate). `sparse` is:
+///
+///   uint32   rows(multiple of 8), cols(multiple of 4)
+///   float    scale[rows]
+///   for each block row(rows / 8):
+///     uint32 num_blocks
+///     uint32 block_col[num_blocks]            column / 4
+///     int8   weights[num_blocks][8][4]        in [-127, 127]
+///
+/// Weight(r, c) = scale[r] * weights[...].
+///
+/// Not thread-safe. Create one instance per thread.
+///
+class WaveRNN {
+ public:
+  WaveRNN();
+  ~WaveRNN();
+
+  ///
+  /// Load weights.
+  ///
+  bool load(const std::string& filename);
+
+  bool is_ready() const;
+
+  int sample_rate() const;
+  int hop_length() const;
+  int num_mels() const;
+
+  // True when the network generates pre-emphasized audio(apply
+  // `inv_preemphasis` to the output).
+  bool preemphasized() const;
+
+  ///
+  /// Seed of the sampling RNG. Same seed and input give the same output.
+  ///
+  void set_seed(uint32_t seed);
+
+  ///
+  /// @param[in] mel Mel spectrogram. [num_frames, num_mels]
+  /// @param[in] num_frames The number of frames.
+  /// @param[out] wav num_frames * hop_length samples.
+  ///
+  bool synthesize(const float* mel, size_t num_frames,
+                  std::vector<float>* wav);
+
+ private:
+  class Impl;
+  std::unique_ptr<Impl> impl;
+};
+
+}  // namespace tts
+
+#endif  // WAVERNN_H_